@@ -0,0 +1,198 @@
+#ifndef TICKLES_ANY_NODE_H
+#define TICKLES_ANY_NODE_H
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "behavior_tree.h"
+#include "checkpoint.h"
+
+namespace tickles {
+
+  // Holds any BehaviorTreeNode behind a single indirect call, for trees whose
+  // shape is only known at runtime. Nodes up to kInlineSize bytes that can be
+  // moved without throwing are stored in place, so a vector of AnyNode keeps
+  // small children next to each other with no allocation per node; bigger
+  // ones fall back to the heap.
+  class AnyNode {
+  public:
+    static constexpr std::size_t kInlineSize = 48;
+
+    template <BehaviorTreeNode Node>
+      requires (!std::same_as<std::remove_cvref_t<Node>, AnyNode> && std::copy_constructible<std::remove_cvref_t<Node>>)
+    AnyNode(Node&& node) {
+      using T = std::remove_cvref_t<Node>;
+      if constexpr (stored_inline<T>) {
+	::new (static_cast<void*>(_storage)) T(std::forward<Node>(node));
+	_vtable = &kInline<T>;
+      } else {
+	*reinterpret_cast<T**>(_storage) = new T(std::forward<Node>(node));
+	_vtable = &kHeap<T>;
+      }
+    }
+
+    AnyNode(AnyNode const& other) : _vtable(other._vtable) {
+      _vtable->copy(_storage, other._storage);
+    }
+    AnyNode(AnyNode&& other) noexcept : _vtable(other._vtable) {
+      _vtable->move(_storage, other._storage);
+    }
+    AnyNode& operator=(AnyNode const& other) {
+      if (this != &other) {
+	AnyNode copy(other);
+	*this = std::move(copy);
+      }
+      return *this;
+    }
+    AnyNode& operator=(AnyNode&& other) noexcept {
+      if (this != &other) {
+	_vtable->destroy(_storage);
+	_vtable = other._vtable;
+	_vtable->move(_storage, other._storage);
+      }
+      return *this;
+    }
+    ~AnyNode() {_vtable->destroy(_storage);}
+
+    // Whatever it holds may be hooked, and park a tick.
+    static constexpr Ticking ticking = Ticking::Hooked;
+
+    Result operator()() const {return _vtable->call(_storage);}
+
+    // The type of the node held, so that tick budgets can name it.
+    std::type_info const& type() const {return _vtable->type;}
+    bool is_inline() const {return _vtable->is_inline;}
+
+    void save_memory(CheckpointWriter& writer) const {_vtable->save(_storage, writer);}
+    void restore_memory(CheckpointReader& reader) const {_vtable->restore(_storage, reader);}
+
+    template <typename T>
+    static constexpr bool stored_inline =
+      sizeof(T) <= kInlineSize && alignof(T) <= alignof(std::max_align_t) &&
+      std::is_nothrow_move_constructible_v<T>;
+
+  private:
+    struct VTable {
+      Result (*call)(void const*);
+      void (*copy)(void*, void const*);
+      // Leaves the source empty but destructible.
+      void (*move)(void*, void*) noexcept;
+      void (*destroy)(void*) noexcept;
+      void (*save)(void const*, CheckpointWriter&);
+      void (*restore)(void const*, CheckpointReader&);
+      std::type_info const& type;
+      bool is_inline;
+    };
+
+    template <typename T>
+    static constexpr VTable kInline{
+      [](void const* p) {return (*static_cast<T const*>(p))();},
+      [](void* to, void const* from) {::new (to) T(*static_cast<T const*>(from));},
+      [](void* to, void* from) noexcept {::new (to) T(std::move(*static_cast<T*>(from)));},
+      [](void* p) noexcept {static_cast<T*>(p)->~T();},
+      [](void const* p, CheckpointWriter& writer) {save_tree(writer, *static_cast<T const*>(p));},
+      [](void const* p, CheckpointReader& reader) {restore_tree(reader, *static_cast<T const*>(p));},
+      typeid(T),
+      true};
+
+    template <typename T>
+    static constexpr VTable kHeap{
+      [](void const* p) {return (**static_cast<T* const*>(p))();},
+      [](void* to, void const* from) {*static_cast<T**>(to) = new T(**static_cast<T* const*>(from));},
+      [](void* to, void* from) noexcept {
+	*static_cast<T**>(to) = std::exchange(*static_cast<T**>(from), nullptr);
+      },
+      [](void* p) noexcept {delete *static_cast<T**>(p);},
+      [](void const* p, CheckpointWriter& writer) {save_tree(writer, **static_cast<T* const*>(p));},
+      [](void const* p, CheckpointReader& reader) {restore_tree(reader, **static_cast<T* const*>(p));},
+      typeid(T),
+      false};
+
+    alignas(std::max_align_t) std::byte _storage[kInlineSize];
+    VTable const* _vtable;
+  };
+
+  // Sequence, FallBack and Parallel over children chosen at runtime. The
+  // children live in one vector of AnyNode, and are ticked with the same
+  // rules, tick budget handling and resumption as the hooked composites.
+  template <Combine kind>
+  class DynamicComposite {
+  public:
+    static constexpr Ticking ticking = Ticking::Hooked;
+
+    DynamicComposite() = default;
+    DynamicComposite(std::initializer_list<AnyNode> children) : children(children) {}
+    explicit DynamicComposite(std::vector<AnyNode> children) : children(std::move(children)) {}
+    DynamicComposite(DynamicComposite const&) = default;
+    DynamicComposite(DynamicComposite &&) = default;
+
+    template <BehaviorTreeNode Node>
+    DynamicComposite& add(Node&& node) {
+      children.emplace_back(std::forward<Node>(node));
+      return *this;
+    }
+
+    void reserve(std::size_t n) {children.reserve(n);}
+    std::size_t size() const {return children.size();}
+
+    template <typename F>
+    void for_each_child(F&& f) const {
+      for (AnyNode const& child : children) f(child);
+    }
+
+    Result operator()() const {
+      Result result = combine();
+      if (!tick_suspended()) cursor = {};
+      return result;
+    }
+
+  private:
+    Result combine() const {
+      Result so_far = cursor.partial;
+      for (std::size_t k = cursor.next; k < children.size(); ++k) {
+	Result kth_result = tick(children[k]);
+	if (tick_suspended()) return park(k, so_far);
+	if constexpr (kind == Combine::Sequence) {
+	  if (kth_result != Result::Succeeded) return kth_result;
+	} else if constexpr (kind == Combine::FallBack) {
+	  if (kth_result != Result::Failed) return kth_result;
+	} else {
+	  if (kth_result == Result::Failed) return Result::Failed;
+	  so_far = so_far == Result::Succeeded && kth_result == Result::Succeeded ?
+	    Result::Succeeded : Result::Running;
+	}
+	if (k + 1 == children.size()) break;
+	switch (at_boundary()) {
+	case Boundary::Abort: return Result::Running;
+	case Boundary::Suspend: return park(k + 1, so_far);
+	case Boundary::Continue: break;
+	}
+      }
+      if constexpr (kind == Combine::Sequence) return Result::Succeeded;
+      else if constexpr (kind == Combine::FallBack) return Result::Failed;
+      else return so_far;
+    }
+
+    Result park(std::size_t next, Result so_far) const {
+      cursor = {static_cast<std::uint32_t>(next), so_far};
+      return Result::Running;
+    }
+
+    std::vector<AnyNode> children;
+    mutable Cursor cursor;
+  };
+
+  using DynamicSequence = DynamicComposite<Combine::Sequence>;
+  using DynamicFallBack = DynamicComposite<Combine::FallBack>;
+  using DynamicParallel = DynamicComposite<Combine::Parallel>;
+
+} // namespace tickles
+
+#endif
@@ -0,0 +1,149 @@
+#include <array>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "any_node.h"
+#include "behavior_tree.h"
+#include "clock.h"
+#include "tick_budget.h"
+
+using tickles::AlwaysFailed;
+using tickles::AlwaysRunning;
+using tickles::AlwaysSucceeded;
+using tickles::AnyNode;
+using tickles::DynamicFallBack;
+using tickles::DynamicParallel;
+using tickles::DynamicSequence;
+using tickles::FallBack;
+using tickles::ManualClock;
+using tickles::Parallel;
+using tickles::Result;
+using tickles::Sequence;
+using tickles::TickBudget;
+
+using namespace std::chrono_literals;
+
+namespace {
+
+  struct Counting {
+    std::shared_ptr<int> calls;
+    Result operator()() const {
+      ++*calls;
+      return Result::Succeeded;
+    }
+  };
+
+  struct Big {
+    std::array<char, 200> padding{};
+    Result operator()() const {return Result::Running;}
+  };
+
+  struct Slow {
+    std::shared_ptr<ManualClock> clock;
+    Result operator()() const {
+      clock->advance(10ms);
+      return Result::Succeeded;
+    }
+  };
+
+  AnyNode leaf(int which) {
+    switch (which) {
+    case 0: return AlwaysRunning{};
+    case 1: return AlwaysSucceeded{};
+    default: return AlwaysFailed{};
+    }
+  }
+
+  template <template <typename...> class Static>
+  Result static_tree(int a, int b, int c) {
+    auto make = [](int which) {return leaf(which);};
+    Static<AnyNode, AnyNode, AnyNode> tree(make(a), make(b), make(c));
+    return tree();
+  }
+
+}
+
+TEST(AnyNode, SmallNodesAreInline) {
+  auto calls = std::make_shared<int>(0);
+  AnyNode node = Counting{calls};
+  EXPECT_TRUE(node.is_inline());
+  EXPECT_EQ(node(), Result::Succeeded);
+  EXPECT_EQ(*calls, 1);
+  EXPECT_EQ(node.type(), typeid(Counting));
+}
+
+TEST(AnyNode, BigNodesGoToTheHeap) {
+  AnyNode node = Big{};
+  EXPECT_FALSE(node.is_inline());
+  EXPECT_EQ(node(), Result::Running);
+}
+
+TEST(AnyNode, CopiesAndMoves) {
+  auto calls = std::make_shared<int>(0);
+  AnyNode small = Counting{calls};
+  AnyNode big = Big{};
+  AnyNode small_copy = small;
+  AnyNode big_copy = big;
+  AnyNode moved = std::move(small);
+  small_copy();
+  moved();
+  EXPECT_EQ(*calls, 2);
+  EXPECT_EQ(calls.use_count(), 3);
+  big_copy = moved;
+  EXPECT_EQ(big_copy(), Result::Succeeded);
+  moved = std::move(big);
+  EXPECT_EQ(moved(), Result::Running);
+}
+
+TEST(AnyNode, IsAChildOfStaticComposites) {
+  for (int a = 0; a < 3; ++a) {
+    for (int b = 0; b < 3; ++b) {
+      for (int c = 0; c < 3; ++c) {
+	EXPECT_EQ(static_tree<Sequence>(a, b, c), (DynamicSequence{leaf(a), leaf(b), leaf(c)}()));
+	EXPECT_EQ(static_tree<FallBack>(a, b, c), (DynamicFallBack{leaf(a), leaf(b), leaf(c)}()));
+	EXPECT_EQ(static_tree<Parallel>(a, b, c), (DynamicParallel{leaf(a), leaf(b), leaf(c)}()));
+      }
+    }
+  }
+}
+
+TEST(AnyNode, EmptyDynamicComposites) {
+  EXPECT_EQ(DynamicSequence{}(), Sequence<>{}());
+  EXPECT_EQ(DynamicFallBack{}(), FallBack<>{}());
+  EXPECT_EQ(DynamicParallel{}(), Parallel<>{}());
+}
+
+TEST(AnyNode, DynamicCompositesNest) {
+  DynamicSequence tree;
+  tree.add(AlwaysSucceeded{})
+    .add(DynamicFallBack{AlwaysFailed{}, AlwaysSucceeded{}})
+    .add(Sequence<AlwaysSucceeded, AnyNode>(AlwaysSucceeded{}, AnyNode(AlwaysRunning{})));
+  EXPECT_EQ(tree.size(), 3);
+  EXPECT_EQ(tree(), Result::Running);
+}
+
+TEST(AnyNode, BudgetNamesTheErasedNode) {
+  auto clock = std::make_shared<ManualClock>();
+  DynamicSequence tree{Slow{clock}, Slow{clock}, Slow{clock}};
+  TickBudget budget(*clock, clock->now() + 5ms);
+  EXPECT_EQ(tree(), Result::Running);
+  ASSERT_TRUE(budget.exhausted());
+  EXPECT_EQ(*budget.overrun()->node, typeid(Slow));
+}
+
+TEST(AnyNode, DynamicCompositesResume) {
+  auto clock = std::make_shared<ManualClock>();
+  DynamicParallel tree{Slow{clock}, AnyNode(AlwaysRunning{}), Slow{clock}};
+  int slices = 0;
+  Result result;
+  do {
+    ++slices;
+    TickBudget budget(*clock, clock->now() + 5ms, TickBudget::Suspend);
+    result = tree();
+    if (!budget.suspended()) break;
+  } while (true);
+  EXPECT_EQ(slices, 2);
+  EXPECT_EQ(result, Result::Running);
+}
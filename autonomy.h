@@ -1,44 +1,352 @@
 #ifndef TICKLES_AUTONOMY_H
 #define TICKLES_AUTONOMY_H
 
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "autonomy_scope.h"
+#include "checkpoint.h"
+#include "clock.h"
+#include "lazy_input.h"
 #include "mutable.h"
+#include "tick_budget.h"
+#include "tick_observer.h"
 #include "boost/di.hpp"
 
 namespace tickles {
 
-  template<typename DataT, typename BehaviorTreeT>
+  // What happens to the writes of a tick that ran out of time.
+  enum class OverrunPolicy {Commit, Discard};
+
+  enum class SyncStatus {Completed, DeadlineExceeded, Suspended};
+
+  // InjectedClockT is the clock the Autonomy's objects are injected with,
+  // as std::shared_ptr<InjectedClockT>; Mutable histories are stamped with
+  // its time.
+  template<typename DataT, typename BehaviorTreeT, TickClock InjectedClockT = SteadyClock>
   class Autonomy {
+    static_assert(std::same_as<typename InjectedClockT::time_point, std::chrono::steady_clock::time_point>,
+		  "Mutable histories are stamped in steady_clock time");
   public:
-    Autonomy() : _impl(init()) {}
+    Autonomy() : _pinned(std::make_unique<Pinned>()) {
+      objects().mutable_registry->stamp_with([clock = objects().clock] {return clock->now();});
+    }
+    // Movable, as what the tree and other threads hold on to stays where it
+    // is; a moved-from Autonomy can only be destroyed or assigned to. Not
+    // copyable.
     Autonomy(Autonomy &&) = default;
-    Autonomy(Autonomy const&) = default;
+    Autonomy& operator=(Autonomy &&) = default;
+    Autonomy(Autonomy const&) = delete;
     
     void sync() {
+      Observing observing(*this);
+      OrderedPass::Install ordered(begin_ordered());
+      BehaviorTreeT const& tree = behavior_tree();
+      do {
+	pass(tree);
+      } while (objects().mutable_registry->sync());
+    }
+
+    // Like sync(), but gives up once deadline has passed. Children of hooked
+    // composites not yet ticked are skipped, composites cut short report
+    // Running, and the writes made so far are committed or dropped according
+    // to policy. A tree with no hooked composite is only checked between
+    // passes.
+    template <TickClock ClockT = SteadyClock>
+    SyncStatus sync(TickBudget::time_point deadline,
+		    OverrunPolicy policy = OverrunPolicy::Commit,
+		    ClockT const& clock = ClockT{}) {
+      TickBudget budget(clock, deadline);
+      Observing observing(*this);
+      OrderedPass::Install ordered(begin_ordered());
+      BehaviorTreeT const& tree = behavior_tree();
       do {
-	_impl.behavior_tree();
-      } while (_impl.mutable_registry->sync());
+	pass(tree);
+	budget.check(typeid(BehaviorTreeT));
+	if (budget.exhausted()) {
+	  if (policy == OverrunPolicy::Commit) objects().mutable_registry->sync();
+	  else objects().mutable_registry->discard();
+	  if (_overrun_handler) _overrun_handler(*budget.overrun());
+	  return SyncStatus::DeadlineExceeded;
+	}
+      } while (objects().mutable_registry->sync());
+      return SyncStatus::Completed;
+    }
+
+    // Anytime evaluation for trees too big to tick in one frame. Runs for
+    // roughly slice (plus the node that is executing when it runs out), then
+    // parks the tick at the next child boundary of a hooked composite and
+    // returns Suspended; the next sync_slice() resumes from there, and a
+    // sync() or sync(deadline) finishes the parked pass before starting any
+    // other. Static subtrees run whole, so the tree's hooked composites set
+    // how finely it is sliced. Nothing is committed until a whole pass has
+    // been evaluated, so readers only ever see complete passes.
+    template <TickClock ClockT = SteadyClock>
+    SyncStatus sync_slice(typename ClockT::duration slice, ClockT const& clock = ClockT{}) {
+      TickBudget budget(clock, clock.now() + slice, TickBudget::Suspend);
+      Observing observing(*this);
+      OrderedPass::Install ordered(begin_ordered());
+      BehaviorTreeT const& tree = behavior_tree();
+      while (true) {
+	if (pass(tree)) return SyncStatus::Suspended;
+	if (!objects().mutable_registry->sync()) return SyncStatus::Completed;
+	budget.check(typeid(BehaviorTreeT));
+	if (budget.exhausted()) return SyncStatus::Suspended;
+      }
+    }
+
+    // Builds a tree wired to this Autonomy's own inputs, Mutables and
+    // registry, ready for swap_tree(). Meant to run off the tick thread. TreeT
+    // may differ from BehaviorTreeT when the root can hold it, as with
+    // AnyNode or the dynamic composites.
+    //
+    // Objects the new tree needs that the old one did not are created here.
+    // New Mutables register with the MutableRegistry, which is safe to do
+    // while the tick thread syncs; they take part in commits from the next
+    // sync() on.
+    template <typename TreeT = BehaviorTreeT>
+    std::unique_ptr<BehaviorTreeT> prepare_tree() {
+      AutonomyScope::Install install(_pinned->scope);
+      auto injector = boost::di::make_injector<AutonomyConfig>();
+      if constexpr (std::same_as<TreeT, BehaviorTreeT>) {
+	return injector.template create<std::unique_ptr<BehaviorTreeT>>();
+      } else {
+	return std::make_unique<BehaviorTreeT>(BehaviorTreeT{injector.template create<TreeT>()});
+      }
+    }
+
+    // Hands tree to the tick thread, which starts using it at the beginning
+    // of its next sync() (or, for sync_slice(), of its next pass). All the
+    // tick thread does is exchange pointers: the tree it replaces goes onto
+    // a list of retired trees, which only swap_tree() and
+    // collect_retired_trees() destroy, never the tick thread. A tree
+    // published but not yet picked up is replaced.
+    void swap_tree(std::unique_ptr<BehaviorTreeT> tree) {
+      collect_retired_trees();
+      delete _pinned->pending_tree.exchange(new TreeSlot{std::move(tree)}, std::memory_order_acq_rel);
+    }
+
+    // Destroys the trees the tick thread has swapped out; off the tick
+    // thread, as destroying a tree may wait for a commit to finish.
+    void collect_retired_trees() {
+      _pinned->collect_retired_trees();
+    }
+
+    // How many swaps the tick thread has taken up.
+    std::uint64_t tree_generation() const {
+      return _pinned->tree_generation.load(std::memory_order_acquire);
+    }
+
+    // Makes sync() evaluate in tree order for value types that take
+    // mutable_hooks: a leaf sees what leaves ticked before it set in the same
+    // pass, rather than what the last pass committed, and another pass only
+    // runs if such a value changed after something in the pass had already
+    // read it, or a value of another type changed. The order is the tree's
+    // own, which no sync() rearranges, since a Sequence or Fallback means
+    // something by it. So a tree is sure to settle in one pass when its
+    // leaves come after the writers of what they read (see single_pass in
+    // tree_traits.h); each leaf that reads a value a later leaf changes, and
+    // each cycle (see FixpointTrace::cycles()), still costs whole extra
+    // passes, repeated until nothing read is changed. Where there is more
+    // than one fixed point, the one reached may differ from the one a plain
+    // sync() would reach. Off by default, and does nothing for a tree that
+    // only reads and writes other value types.
+    void evaluate_in_order(bool on = true) {_ordered = on;}
+
+    void on_overrun(std::function<void(Overrun const&)> handler) {
+      _overrun_handler = std::move(handler);
+    }
+
+    // Reports every sync() to observer, or to nobody if it is null: a
+    // FixpointTrace, an EventTracer, AutonomyMetrics, or several of them
+    // through TickObservers. observer must outlive this Autonomy or be
+    // replaced first.
+    void observe(TickObserver* observer) {_observer = observer;}
+
+    // Writes a snapshot of everything in this Autonomy that is
+    // Checkpointable (committed Mutable values, inputs, blackboards) and of
+    // the memory of its tree's nodes into buffer, which may be a
+    // CheckpointFile's. Returns the snapshot's size, or 0 if it did not fit.
+    // Call between syncs.
+    std::size_t checkpoint(std::span<std::byte> buffer) const {
+      CheckpointWriter writer(buffer);
+      std::size_t at = begin_checkpoint(writer);
+      _pinned->scope.checkpoint(writer);
+      std::size_t tree = writer.begin_entry(tree_key());
+      save_tree(writer, *objects().behavior_tree);
+      writer.end_entry(tree);
+      return end_checkpoint(writer, at);
+    }
+
+    // Restores a snapshot taken by checkpoint() in the same build, before
+    // the first sync(); objects it has no entry for keep their state.
+    // Returns false if the snapshot is damaged or an entry does not fit the
+    // object it was written from. Nothing is changed then, except that
+    // Mutables the snapshot had already reached before the bad entry count
+    // being put back in their version().
+    bool restore(std::span<std::byte const> snapshot) {
+      auto entries = checkpoint_entries(snapshot);
+      if (!entries) return false;
+      // Entries are applied one at a time, so first keep what they replace.
+      std::vector<std::byte> previous(snapshot.size() + 256);
+      std::size_t size;
+      while (!(size = checkpoint(previous))) previous.resize(previous.size() * 2);
+      if (apply(*entries)) return true;
+      apply(*checkpoint_entries(std::span(previous).first(size)));
+      return false;
+    }
+
+    // For DeltaEncoder and DeltaDecoder; like them, on the tick thread
+    // between syncs.
+    MutableRegistry& mutable_registry() {
+      return *objects().mutable_registry;
+    }
+
+    // The clock this Autonomy's objects were injected with; the one to
+    // advance when it is a ManualClock.
+    InjectedClockT& clock() {
+      return *objects().clock;
     }
 
     DataT& data() {
-      return _impl.data;
+      return objects().data;
     }
 
     const DataT& data() const {
-      return _impl.data;
+      return objects().data;
     }
     
   private:
     struct impl {
       DataT data;
-      BehaviorTreeT behavior_tree;
+      std::unique_ptr<BehaviorTreeT> behavior_tree;
       std::shared_ptr<MutableRegistry> mutable_registry;
+      std::shared_ptr<TickEpoch> tick_epoch;
+      std::shared_ptr<InjectedClockT> clock;
     };
-    
-    impl init() {
-      return boost::di::make_injector().create<impl>();
+
+    // Also where a tick starts, unless sync_slice() is resuming one.
+    BehaviorTreeT const& behavior_tree() {
+      if (!_mid_pass) objects().tick_epoch->advance();
+      if (!_mid_pass && _pinned->pending_tree.load(std::memory_order_relaxed)) {
+	if (TreeSlot* next = _pinned->pending_tree.exchange(nullptr, std::memory_order_acquire)) {
+	  // The slot that brought the new tree takes the old one away.
+	  std::swap(next->tree, objects().behavior_tree);
+	  next->next = _pinned->retired_trees.load(std::memory_order_relaxed);
+	  while (!_pinned->retired_trees.compare_exchange_weak(next->next, next, std::memory_order_release,
+						      std::memory_order_relaxed)) {}
+	  _pinned->tree_generation.fetch_add(1, std::memory_order_release);
+	}
+      }
+      return *objects().behavior_tree;
     }
     
-    impl _impl;
+    template <typename T>
+    struct TreeMemory {};
+
+    // Whether every entry was read in full.
+    bool apply(std::span<std::byte const> entries) {
+      CheckpointReader reader(entries);
+      bool applied = true;
+      while (auto entry = reader.next_entry()) {
+	if (entry->key == tree_key()) {
+	  CheckpointReader tree(entry->data);
+	  restore_tree(tree, *objects().behavior_tree);
+	  applied &= !tree.failed() && tree.done();
+	} else {
+	  applied &= _pinned->scope.restore(entry->key, entry->data);
+	}
+      }
+      return applied && !reader.failed();
+    }
+
+    static std::uint64_t tree_key() {return checkpoint_key(typeid(TreeMemory<BehaviorTreeT>));}
+
+    // Installs the observer, if it is active, for one sync() call.
+    class Observing {
+    public:
+      explicit Observing(Autonomy const& autonomy)
+	: _observer(autonomy._observer && autonomy._observer->active() ? autonomy._observer : nullptr),
+	  _install(_observer) {
+	if (_observer) _observer->begin_sync(typeid(BehaviorTreeT), autonomy._mid_pass);
+      }
+      Observing(Observing const&) = delete;
+      ~Observing() {
+	if (_observer) _observer->end_sync(typeid(BehaviorTreeT));
+      }
+    private:
+      TickObserver* _observer;
+      TickObserver::Install _install;
+    };
+
+    // Ticks tree once, or what is left of a pass sync_slice() parked, and
+    // returns whether the pass was parked again. Only a sync_slice() parks
+    // one, so sync() and sync(deadline) finish whatever they find parked.
+    bool pass(BehaviorTreeT const& tree) {
+      TickObserver* observer = TickObserver::current();
+      if (observer) observer->begin_pass(typeid(BehaviorTreeT));
+      if (_ordered && !_mid_pass) _ordered_pass.begin();
+      tree();
+      _mid_pass = tick_suspended();
+      if (observer) observer->end_pass(typeid(BehaviorTreeT));
+      return _mid_pass;
+    }
+
+    OrderedPass* begin_ordered() {
+      return _ordered ? &_ordered_pass : nullptr;
+    }
+
+    static impl init(AutonomyScope& scope) {
+      AutonomyScope::Install install(scope);
+      return boost::di::make_injector<AutonomyConfig>().create<impl>();
+    }
+
+    struct TreeSlot {
+      std::unique_ptr<BehaviorTreeT> tree;
+      TreeSlot* next = nullptr;
+    };
+
+    // Everything the tree holds references into or other threads reach,
+    // which has to stay put when the Autonomy moves.
+    struct Pinned {
+      Pinned() : objects(init(scope)) {}
+      Pinned(Pinned const&) = delete;
+      ~Pinned() {
+	delete pending_tree.exchange(nullptr, std::memory_order_acquire);
+	collect_retired_trees();
+      }
+
+      void collect_retired_trees() {
+	TreeSlot* retired = retired_trees.exchange(nullptr, std::memory_order_acquire);
+	while (retired) delete std::exchange(retired, retired->next);
+      }
+
+      // Declared before objects, which holds references into it.
+      AutonomyScope scope;
+      impl objects;
+      std::atomic<TreeSlot*> pending_tree = nullptr;
+      std::atomic<TreeSlot*> retired_trees = nullptr;
+      std::atomic<std::uint64_t> tree_generation = 0;
+    };
+
+    impl& objects() {return _pinned->objects;}
+    impl const& objects() const {return _pinned->objects;}
+
+    std::unique_ptr<Pinned> _pinned;
+    std::function<void(Overrun const&)> _overrun_handler;
+    TickObserver* _observer = nullptr;
+    OrderedPass _ordered_pass;
+    bool _ordered = false;
+    bool _mid_pass = false;
   };
   
 } // namespace tickles
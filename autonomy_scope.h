@@ -0,0 +1,164 @@
+#ifndef TICKLES_AUTONOMY_SCOPE_H
+#define TICKLES_AUTONOMY_SCOPE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <typeindex>
+#include <unordered_map>
+
+#include "checkpoint.h"
+#include "boost/di.hpp"
+
+namespace tickles {
+
+  // Holds the objects that the data and behavior tree of one Autonomy share.
+  //
+  // Boost.DI's default scope for shared_ptr<T> and T& is a process-wide
+  // singleton, so every Autonomy built from a plain injector would share its
+  // inputs, Mutables and MutableRegistry with every other one. Injectors made
+  // with AutonomyConfig resolve those to objects kept here instead, one set
+  // per AutonomyScope.
+  class AutonomyScope {
+  public:
+    AutonomyScope() = default;
+    AutonomyScope(AutonomyScope const&) = delete;
+    AutonomyScope(AutonomyScope &&) = delete;
+
+    // Makes this the scope that injectors on this thread resolve into.
+    class Install {
+    public:
+      explicit Install(AutonomyScope& scope) : _previous(_current) {_current = &scope;}
+      Install(Install const&) = delete;
+      ~Install() {_current = _previous;}
+    private:
+      AutonomyScope* _previous;
+    };
+
+    // Locked so that a replacement tree can be built on another thread; only
+    // construction ever comes here, never a tick. Recursive because make()
+    // resolves T's own dependencies through the same scope.
+    //
+    // An object with a publish(AutonomyScope&, std::shared_ptr<T> const&)
+    // member gets to adopt() parts of itself once it has been created.
+    template <typename T, typename Make>
+    std::shared_ptr<T> get_or_create(Make&& make) {
+      std::lock_guard lock(_mutex);
+      auto& slot = _objects[std::type_index(typeid(T))];
+      if (!slot) {
+	auto object = std::shared_ptr<T>(make());
+	slot = object;
+	if constexpr (requires {object->publish(*this, object);}) object->publish(*this, object);
+	if constexpr (Checkpointable<T>) {
+	  _checkpointed.insert_or_assign(checkpoint_key(typeid(T)), Checkpointed{
+	      object.get(),
+	      [](void const* p, CheckpointWriter& writer) {writer.put(*static_cast<T const*>(p));},
+	      [](void* p, CheckpointReader& reader) {reader.get(*static_cast<T*>(p));}});
+	}
+      }
+      return std::static_pointer_cast<T>(slot);
+    }
+
+    // Makes object the one every later request for T resolves to. Returns
+    // false, and changes nothing, if a T was already resolved here.
+    template <typename T>
+    bool adopt(std::shared_ptr<T> object) {
+      std::lock_guard lock(_mutex);
+      return _objects.try_emplace(std::type_index(typeid(T)), std::move(object)).second;
+    }
+
+    template <typename T>
+    std::shared_ptr<T> find() const {
+      std::lock_guard lock(_mutex);
+      auto found = _objects.find(std::type_index(typeid(T)));
+      if (found == _objects.end()) return nullptr;
+      return std::static_pointer_cast<T>(found->second);
+    }
+
+    static AutonomyScope* current() {return _current;}
+
+    // One entry for each object created here whose type is Checkpointable.
+    void checkpoint(CheckpointWriter& writer) const {
+      std::lock_guard lock(_mutex);
+      for (auto const& [key, object] : _checkpointed) {
+	std::size_t at = writer.begin_entry(key);
+	object.save(object.object, writer);
+	writer.end_entry(at);
+      }
+    }
+
+    // Restores the object an entry was written from, if there is one here;
+    // returns false only if the entry does not fit it.
+    bool restore(std::uint64_t key, std::span<std::byte const> data) {
+      std::lock_guard lock(_mutex);
+      auto found = _checkpointed.find(key);
+      if (found == _checkpointed.end()) return true;
+      CheckpointReader reader(data);
+      found->second.load(found->second.object, reader);
+      return !reader.failed() && reader.done();
+    }
+
+    // The Boost.DI scope that AutonomyConfig selects for shared objects.
+    template <class TExpected, class TGiven>
+    class scope {
+    public:
+      template <class T_, class>
+      using is_referable = typename boost::di::wrappers::shared<AutonomyScope, TGiven>::template is_referable<T_>;
+
+      template <class, class, class TProvider, class T_ = boost::di::aux::decay_t<decltype(std::declval<TProvider>().get())>>
+      static decltype(boost::di::wrappers::shared<AutonomyScope, T_>{std::shared_ptr<T_>{std::declval<TProvider>().get()}})
+      try_create(const TProvider&);
+
+      template <class, class, class TProvider>
+      auto create(const TProvider& provider) {
+	using T_ = boost::di::aux::decay_t<decltype(provider.get())>;
+	if (AutonomyScope* scope = AutonomyScope::current()) {
+	  return boost::di::wrappers::shared<AutonomyScope, T_>{
+	    scope->get_or_create<T_>([&] {return provider.get();})};
+	}
+	// Outside of any Autonomy fall back to Boost.DI's singleton behaviour.
+	static std::shared_ptr<T_> object{provider.get()};
+	return boost::di::wrappers::shared<AutonomyScope, T_>{object};
+      }
+    };
+
+  private:
+    struct Checkpointed {
+      void* object;
+      void (*save)(void const*, CheckpointWriter&);
+      void (*load)(void*, CheckpointReader&);
+    };
+
+    mutable std::recursive_mutex _mutex;
+    std::unordered_map<std::type_index, std::shared_ptr<void>> _objects;
+    std::unordered_map<std::uint64_t, Checkpointed> _checkpointed;
+
+    static inline thread_local AutonomyScope* _current = nullptr;
+  };
+
+  // Injector configuration used by Autonomy: everything that would otherwise
+  // be a singleton is shared per AutonomyScope instead.
+  struct AutonomyConfig : boost::di::config {
+    template <class T>
+    struct scope_traits {
+      using type = boost::di::scopes::unique;
+    };
+    template <class T>
+    struct scope_traits<T&> {
+      using type = AutonomyScope;
+    };
+    template <class T>
+    struct scope_traits<std::shared_ptr<T>> {
+      using type = AutonomyScope;
+    };
+    template <class T>
+    struct scope_traits<std::weak_ptr<T>> {
+      using type = AutonomyScope;
+    };
+  };
+
+} // namespace tickles
+
+#endif
@@ -0,0 +1,333 @@
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "any_node.h"
+#include "autonomy.h"
+#include "behavior_tree.h"
+#include "clock.h"
+#include "history.h"
+#include "input.h"
+#include "mutable.h"
+
+using tickles::Autonomy;
+using tickles::AnyNode;
+using tickles::DynamicSequence;
+using tickles::Input;
+using tickles::ManualClock;
+using tickles::Mutable;
+using tickles::Mutator;
+using tickles::Overrun;
+using tickles::OverrunPolicy;
+using tickles::Result;
+using tickles::HookedSequence;
+using tickles::Sequence;
+using tickles::SyncStatus;
+
+using namespace std::chrono_literals;
+
+namespace {
+
+  struct Target {
+    int value = 0;
+    bool operator==(Target const&) const = default;
+  };
+
+  struct Slow {
+    std::shared_ptr<ManualClock> clock;
+    Result operator()() const {
+      clock->advance(10ms);
+      return Result::Succeeded;
+    }
+  };
+
+  // Moves the target one step towards the goal per fixpoint iteration.
+  struct WriteTarget {
+    Input<int> const& goal;
+    Mutator<Target> target;
+    Result operator()() const {
+      int value = target.get().value;
+      target.set(Target{value + (goal.get() > value) - (goal.get() < value)});
+      return Result::Succeeded;
+    }
+  };
+
+  struct Tree : HookedSequence<WriteTarget, Slow, Slow> {};
+
+  struct Data {
+    std::shared_ptr<ManualClock> clock;
+    std::shared_ptr<Input<int>> goal;
+    std::shared_ptr<const Mutable<Target>> target;
+    std::shared_ptr<tickles::TickEpoch const> epoch;
+  };
+
+  struct TestAutonomy : Autonomy<Data, Tree> {
+    void goal(int goal) {data().goal->set(goal);}
+  };
+
+}
+
+namespace {
+
+  struct Heading {
+    int value = 0;
+    bool operator==(Heading const&) const = default;
+  };
+
+}
+
+template <> struct tickles::mutable_history<Heading> {static constexpr std::size_t depth = 2;};
+
+namespace {
+
+  struct SetHeading {
+    Input<int> const& goal;
+    Mutator<Heading> heading;
+    Result operator()() const {
+      heading.set(Heading{goal.get()});
+      return Result::Succeeded;
+    }
+  };
+
+  struct HeadingData {
+    std::shared_ptr<ManualClock> clock;
+    std::shared_ptr<Input<int>> goal;
+    std::shared_ptr<const Mutable<Heading>> heading;
+  };
+
+  struct SimulatedAutonomy : Autonomy<HeadingData, Sequence<SetHeading>, ManualClock> {
+    using Autonomy::sync;
+  };
+
+}
+
+TEST(AutonomyClock, StampsHistoryWithInjectedClock) {
+  SimulatedAutonomy autonomy;
+  auto start = std::chrono::steady_clock::time_point{} + 1h;
+  autonomy.data().clock->set(start);
+  autonomy.data().goal->set(90);
+  autonomy.sync();
+  autonomy.data().clock->advance(20ms);
+  autonomy.data().goal->set(180);
+  autonomy.sync();
+  auto history = autonomy.data().heading->history();
+  ASSERT_EQ(history.size(), 2);
+  EXPECT_EQ(history.newest().value.value, 180);
+  EXPECT_EQ(history.newest().at, start + 20ms);
+  EXPECT_EQ(history.oldest().at, start);
+}
+
+struct Deadline : testing::Test {
+  void SetUp() override {
+    autonomy.goal(0);
+    autonomy.sync();
+    autonomy.goal(3);
+  }
+  TestAutonomy autonomy;
+  ManualClock& clock() {return *autonomy.data().clock;}
+};
+
+TEST_F(Deadline, CompletesWithinBudget) {
+  EXPECT_EQ(autonomy.sync(clock().now() + 1s, OverrunPolicy::Commit, clock()),
+	    SyncStatus::Completed);
+  EXPECT_EQ(autonomy.data().target->get().value, 3);
+}
+
+TEST_F(Deadline, CommitsPartialTick) {
+  std::optional<Overrun> overrun;
+  autonomy.on_overrun([&](Overrun const& o) {overrun = o;});
+  EXPECT_EQ(autonomy.sync(clock().now() + 5ms, OverrunPolicy::Commit, clock()),
+	    SyncStatus::DeadlineExceeded);
+  EXPECT_EQ(autonomy.data().target->get().value, 1);
+  ASSERT_TRUE(overrun);
+  EXPECT_EQ(*overrun->node, typeid(Slow));
+}
+
+TEST_F(Deadline, DiscardsPartialTick) {
+  EXPECT_EQ(autonomy.sync(clock().now() + 5ms, OverrunPolicy::Discard, clock()),
+	    SyncStatus::DeadlineExceeded);
+  EXPECT_EQ(autonomy.data().target->get().value, 0);
+}
+
+TEST_F(Deadline, StopsFixpointIteration) {
+  EXPECT_EQ(autonomy.sync(clock().now() + 30ms, OverrunPolicy::Commit, clock()),
+	    SyncStatus::DeadlineExceeded);
+  EXPECT_EQ(autonomy.data().target->get().value, 2);
+}
+
+TEST_F(Deadline, SliceDefersCommitUntilPassCompletes) {
+  // The write happens in the first slice but is held back...
+  EXPECT_EQ(autonomy.sync_slice(5ms, clock()), SyncStatus::Suspended);
+  EXPECT_EQ(autonomy.data().target->get().value, 0);
+  // ...until the slice that finishes the pass.
+  EXPECT_EQ(autonomy.sync_slice(5ms, clock()), SyncStatus::Suspended);
+  EXPECT_EQ(autonomy.data().target->get().value, 1);
+}
+
+TEST_F(Deadline, SlicesConvergeToFullSync) {
+  int calls = 0;
+  while (autonomy.sync_slice(25ms, clock()) == SyncStatus::Suspended) ++calls;
+  EXPECT_EQ(autonomy.data().target->get().value, 3);
+  EXPECT_EQ(calls, 2);
+}
+
+TEST_F(Deadline, SyncFinishesSlicedPass) {
+  EXPECT_EQ(autonomy.sync_slice(5ms, clock()), SyncStatus::Suspended);
+  std::uint64_t epoch = autonomy.data().epoch->current();
+  autonomy.sync();
+  EXPECT_EQ(autonomy.data().target->get().value, 3);
+  EXPECT_EQ(autonomy.data().epoch->current(), epoch);
+
+  // Every sync after that is a tick of its own, sliced or not.
+  autonomy.goal(1);
+  EXPECT_EQ(autonomy.sync_slice(5ms, clock()), SyncStatus::Suspended);
+  EXPECT_EQ(autonomy.data().epoch->current(), epoch + 1);
+  EXPECT_EQ(autonomy.sync(clock().now() + 1s, OverrunPolicy::Commit, clock()), SyncStatus::Completed);
+  EXPECT_EQ(autonomy.data().target->get().value, 1);
+  autonomy.sync();
+  EXPECT_EQ(autonomy.data().epoch->current(), epoch + 2);
+  EXPECT_EQ(autonomy.sync_slice(1s, clock()), SyncStatus::Completed);
+  EXPECT_EQ(autonomy.data().epoch->current(), epoch + 3);
+}
+
+TEST(Autonomy, InstancesDoNotShareState) {
+  TestAutonomy a, b;
+  a.goal(2);
+  b.goal(-1);
+  a.sync();
+  b.sync();
+  EXPECT_EQ(a.data().target->get().value, 2);
+  EXPECT_EQ(b.data().target->get().value, -1);
+  EXPECT_NE(a.data().clock, b.data().clock);
+}
+
+TEST(Autonomy, MovesWithItsState) {
+  TestAutonomy first;
+  first.goal(2);
+  first.sync();
+  first.swap_tree(first.prepare_tree());
+
+  std::vector<TestAutonomy> moved;
+  moved.push_back(std::move(first));
+  TestAutonomy& autonomy = moved.back();
+  EXPECT_EQ(autonomy.data().target->get().value, 2);
+  autonomy.goal(4);
+  autonomy.sync();
+  EXPECT_EQ(autonomy.tree_generation(), 1);
+  EXPECT_EQ(autonomy.data().target->get().value, 4);
+
+  first = std::move(autonomy);
+  first.goal(0);
+  first.sync();
+  EXPECT_EQ(first.data().target->get().value, 0);
+}
+
+struct HotSwap : testing::Test {
+  TestAutonomy autonomy;
+};
+
+TEST_F(HotSwap, KeepsMutableState) {
+  autonomy.goal(3);
+  autonomy.sync();
+  autonomy.swap_tree(autonomy.prepare_tree());
+  EXPECT_EQ(autonomy.tree_generation(), 0);
+  autonomy.sync();
+  EXPECT_EQ(autonomy.tree_generation(), 1);
+  EXPECT_EQ(autonomy.data().target->get().value, 3);
+  autonomy.goal(1);
+  autonomy.sync();
+  EXPECT_EQ(autonomy.data().target->get().value, 1);
+}
+
+TEST_F(HotSwap, LastPublishedTreeWins) {
+  autonomy.swap_tree(autonomy.prepare_tree());
+  autonomy.swap_tree(autonomy.prepare_tree());
+  autonomy.sync();
+  EXPECT_EQ(autonomy.tree_generation(), 1);
+}
+
+TEST_F(HotSwap, SyncAfterSlicePicksUpSwappedTree) {
+  autonomy.goal(3);
+  ManualClock& clock = *autonomy.data().clock;
+  EXPECT_EQ(autonomy.sync_slice(5ms, clock), SyncStatus::Suspended);
+  autonomy.swap_tree(autonomy.prepare_tree());
+  // The parked pass ends on the tree it started on.
+  autonomy.sync();
+  EXPECT_EQ(autonomy.tree_generation(), 0);
+  autonomy.sync();
+  EXPECT_EQ(autonomy.tree_generation(), 1);
+  EXPECT_EQ(autonomy.data().target->get().value, 3);
+}
+
+TEST_F(HotSwap, WaitsForSlicedPassToFinish) {
+  autonomy.goal(3);
+  ManualClock& clock = *autonomy.data().clock;
+  EXPECT_EQ(autonomy.sync_slice(5ms, clock), SyncStatus::Suspended);
+  autonomy.swap_tree(autonomy.prepare_tree());
+  EXPECT_EQ(autonomy.sync_slice(5ms, clock), SyncStatus::Suspended);
+  EXPECT_EQ(autonomy.tree_generation(), 0);
+  EXPECT_EQ(autonomy.data().target->get().value, 1);
+  autonomy.sync_slice(5ms, clock);
+  EXPECT_EQ(autonomy.tree_generation(), 1);
+}
+
+// A root that starts out empty and can take any tree later.
+struct AnyRoot {
+  using boost_di_inject__ = boost::di::inject<>;
+  AnyRoot() = default;
+  template <typename Node> requires (!std::same_as<Node, AnyRoot>)
+  explicit AnyRoot(Node node) : root{AnyNode(std::move(node))} {}
+  Result operator()() const {return root();}
+  DynamicSequence root;
+};
+
+TEST(HotSwapShape, DynamicRootTakesAnyTree) {
+  struct Empty : Autonomy<Data, AnyRoot> {
+    void goal(int goal) {data().goal->set(goal);}
+  } autonomy;
+  autonomy.goal(2);
+  autonomy.sync();
+  EXPECT_EQ(autonomy.data().target->get().value, 0);
+
+  autonomy.swap_tree(autonomy.prepare_tree<Tree>());
+  autonomy.sync();
+  EXPECT_EQ(autonomy.data().target->get().value, 2);
+}
+
+// Keeps its token alive for as long as the tree holding it lives.
+struct Holder {
+  std::shared_ptr<int> token;
+  Result operator()() const {return Result::Succeeded;}
+};
+
+TEST(HotSwapShape, TickThreadNeverDestroysTrees) {
+  struct Empty : Autonomy<Data, AnyRoot> {} autonomy;
+  auto token = std::make_shared<int>();
+  autonomy.swap_tree(std::make_unique<AnyRoot>(Holder{token}));
+  autonomy.sync();
+  autonomy.swap_tree(std::make_unique<AnyRoot>());
+  autonomy.sync();
+  EXPECT_EQ(autonomy.tree_generation(), 2);
+  EXPECT_GT(token.use_count(), 1);
+  autonomy.collect_retired_trees();
+  EXPECT_EQ(token.use_count(), 1);
+}
+
+TEST_F(HotSwap, SwapsFromAnotherThread) {
+  std::atomic<bool> done = false;
+  std::thread loader([&] {
+    while (!done) autonomy.swap_tree(autonomy.prepare_tree());
+  });
+  for (int i = 0; i < 2000; ++i) {
+    autonomy.goal(i % 5);
+    autonomy.sync();
+    ASSERT_EQ(autonomy.data().target->get().value, i % 5);
+  }
+  done = true;
+  loader.join();
+}
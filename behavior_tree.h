@@ -1,16 +1,27 @@
 #ifndef TICKLES_NODE2_H
 #define TICKLES_NODE2_H
 
+#include <concepts>
+#include <cstdint>
 #include <optional>
 #include <ios>
 #include <string>
 #include <string_view>
 #include <tuple>
+#include <type_traits>
+#include <typeinfo>
+
+#include "tick_budget.h"
+#include "tick_observer.h"
 
 namespace tickles {
   
   enum class Result {Running, Succeeded, Failed};
 
+  // The rules by which Sequence, FallBack and Parallel combine their
+  // children's Results.
+  enum class Combine {Sequence, FallBack, Parallel};
+
   std::string_view ToString(Result r);
   
   std::ostream& operator<<(std::ostream& os, Result r);
@@ -24,45 +35,170 @@ namespace tickles {
   template <typename T>
   concept BehaviorTreeNode = requires (T t) {Result{t()};};
 
-  template<BehaviorTreeNode... Children> 
-  class Parallel {
+  template<BehaviorTreeNode Node>
+  std::type_info const& node_type(Node const& node) {
+    if constexpr (requires {{node.type()} -> std::same_as<std::type_info const&>;}) return node.type();
+    else return typeid(Node);
+  }
+
+  // How hooked composites evaluate a child: lets the installed TickObserver,
+  // if any, see the node begin and end, and the running TickBudget note
+  // which node was executing when the deadline passed. Type-erased nodes
+  // name what they hold through type().
+  template<BehaviorTreeNode Node>
+  Result tick(Node const& node) {
+    TickObserver* observer = TickObserver::current();
+    if (observer) observer->begin_node(node_type(node));
+    Result result = node();
+    if (observer) observer->end_node(node_type(node));
+    if (TickBudget* budget = TickBudget::current()) budget->check(node_type(node));
+    return result;
+  }
+
+  // How a composite ticks its children. A static one calls them and keeps
+  // nothing, so a tree of static composites costs what its leaves do. A
+  // hooked one ticks them through tick(), stops or parks the tick at a child
+  // boundary once the running TickBudget is spent, and resumes a parked
+  // tick from a Cursor, for a few thread-local loads per child. A composite
+  // over a hooked child is hooked itself, so that a tick parked below it
+  // resumes through it; below a static composite, nothing is seen by
+  // observers or budgets until it returns.
+  enum class Ticking {Static, Hooked};
+
+  // Nodes other than composites are static unless they say otherwise.
+  template<typename Node>
+  constexpr Ticking ticking_of = [] {
+    if constexpr (requires {{Node::ticking} -> std::convertible_to<Ticking>;}) return Node::ticking;
+    else return Ticking::Static;
+  }();
+
+  template<Ticking declared, typename... Children>
+  constexpr Ticking ticking_over =
+    declared == Ticking::Hooked || ((ticking_of<Children> == Ticking::Hooked) || ...) ?
+    Ticking::Hooked : Ticking::Static;
+
+  template<Ticking ticking, BehaviorTreeNode Node>
+  Result tick_child(Node const& node) {
+    if constexpr (ticking == Ticking::Hooked) return tick(node);
+    else return node();
+  }
+
+  enum class Boundary {Continue, Abort, Suspend};
+
+  // What a hooked composite that just ticked a child should do before the
+  // next one.
+  inline Boundary at_boundary() {
+    TickBudget* budget = TickBudget::current();
+    if (!budget || !budget->exhausted()) return Boundary::Continue;
+    if (budget->mode() == TickBudget::Abort) return Boundary::Abort;
+    budget->suspend();
+    return Boundary::Suspend;
+  }
+
+  // The same for child i of size; there is no boundary after the last one.
+  template<std::size_t i, std::size_t size>
+  Boundary at_boundary() {
+    if constexpr (i + 1 < size) return at_boundary();
+    return Boundary::Continue;
+  }
+
+  // Where a hooked composite left off when a time-sliced tick was suspended
+  // inside it: children before next are not ticked again on resumption, and
+  // partial is what they added up to so far.
+  struct Cursor {
+    std::uint32_t next = 0;
+    Result partial = Result::Succeeded;
+  };
+
+  // What a static composite keeps instead.
+  struct NoCursor {};
+
+  template<Ticking ticking>
+  using cursor_for = std::conditional_t<ticking == Ticking::Hooked, Cursor, NoCursor>;
+
+  template<Ticking declared, BehaviorTreeNode... Children> 
+  class BasicParallel {
   public:
-    Parallel(Children&&... children): children(std::forward<Children>(children)...){}
-    Parallel(Parallel const&) = default;
-    Parallel(Parallel&&) = default;
+    using child_types = std::tuple<Children...>;
+    static constexpr Ticking ticking = ticking_over<declared, Children...>;
+
+    BasicParallel(Children&&... children): children(std::forward<Children>(children)...){}
+    BasicParallel(BasicParallel const&) = default;
+    BasicParallel(BasicParallel&&) = default;
+
+    template <typename F>
+    void for_each_child(F&& f) const {
+      std::apply([&](auto const&... child) {(f(child), ...);}, children);
+    }
     
     Result operator()() const {
-      return in_parallel<0>();
+      if constexpr (ticking == Ticking::Static) return in_parallel<0>(Result::Succeeded);
+      else {
+	Result result = in_parallel<0>(cursor.partial);
+	if (!tick_suspended()) cursor = {};
+	return result;
+      }
     }
   private:
       
     template<int i>
-    Result in_parallel() const requires(i >= sizeof...(Children)) {
-      return Result::Succeeded;
+    Result in_parallel(Result so_far) const requires(i >= sizeof...(Children)) {
+      return so_far;
     }
     template<int i>
-    Result in_parallel() const requires (i < sizeof...(Children)) {
-      Result ith_result = std::get<i>(children)();
+    Result in_parallel(Result so_far) const requires (i < sizeof...(Children)) {
+      if constexpr (ticking == Ticking::Hooked) {
+	if (i < cursor.next) return in_parallel<i+1>(so_far);
+      }
+      Result ith_result = tick_child<ticking>(std::get<i>(children));
+      if constexpr (ticking == Ticking::Hooked) {
+	if (tick_suspended()) return park(i, so_far);
+      }
       if (ith_result == Result::Failed) return Result::Failed;
-      Result rest_result = in_parallel<i+1>();
-      return rest_result == Result::Failed ? Result::Failed:
-	ith_result == Result::Succeeded && rest_result == Result::Succeeded ? Result::Succeeded :
-	Result::Running;
+      so_far = so_far == Result::Succeeded && ith_result == Result::Succeeded ?
+	Result::Succeeded : Result::Running;
+      if constexpr (ticking == Ticking::Hooked) {
+	switch (at_boundary<i, sizeof...(Children)>()) {
+	case Boundary::Abort: return Result::Running;
+	case Boundary::Suspend: return park(i+1, so_far);
+	case Boundary::Continue: break;
+	}
+      }
+      return in_parallel<i+1>(so_far);
+    }
+
+    Result park(std::uint32_t next, Result so_far) const {
+      cursor = {next, so_far};
+      return Result::Running;
     }
     
     std::tuple<Children...> children;
+    [[no_unique_address]] mutable cursor_for<ticking> cursor;
   };
 
   
-  template<BehaviorTreeNode... Children>
-  class Sequence {
+  template<Ticking declared, BehaviorTreeNode... Children>
+  class BasicSequence {
   public:
-    Sequence(Children&&... children): children(std::forward<Children>(children)...){}
-    Sequence(Sequence const&) = default;
-    Sequence(Sequence &&) = default;
+    using child_types = std::tuple<Children...>;
+    static constexpr Ticking ticking = ticking_over<declared, Children...>;
+
+    BasicSequence(Children&&... children): children(std::forward<Children>(children)...){}
+    BasicSequence(BasicSequence const&) = default;
+    BasicSequence(BasicSequence &&) = default;
+
+    template <typename F>
+    void for_each_child(F&& f) const {
+      std::apply([&](auto const&... child) {(f(child), ...);}, children);
+    }
 
     Result operator()() const {
-      return in_sequence<0>();
+      if constexpr (ticking == Ticking::Static) return in_sequence<0>();
+      else {
+	Result result = in_sequence<0>();
+	if (!tick_suspended()) cursor = {};
+	return result;
+      }
     }
 
   private:
@@ -72,23 +208,57 @@ namespace tickles {
     }
     template<int i>
     Result in_sequence() const requires (i < sizeof...(Children)) {
-      Result first_result = std::get<i>(children)();
-      if (first_result == Result::Succeeded) return in_sequence<i+1>();
+      if constexpr (ticking == Ticking::Hooked) {
+	if (i < cursor.next) return in_sequence<i+1>();
+      }
+      Result first_result = tick_child<ticking>(std::get<i>(children));
+      if constexpr (ticking == Ticking::Hooked) {
+	if (tick_suspended()) return park(i);
+      }
+      if (first_result == Result::Succeeded) {
+	if constexpr (ticking == Ticking::Hooked) {
+	  switch (at_boundary<i, sizeof...(Children)>()) {
+	  case Boundary::Abort: return Result::Running;
+	  case Boundary::Suspend: return park(i+1);
+	  case Boundary::Continue: break;
+	  }
+	}
+	return in_sequence<i+1>();
+      }
       return first_result;
     };
 
+    Result park(std::uint32_t next) const {
+      cursor.next = next;
+      return Result::Running;
+    }
+
     std::tuple<Children...> children;
+    [[no_unique_address]] mutable cursor_for<ticking> cursor;
   };
   
-  template<BehaviorTreeNode... Children>
-  class FallBack {
+  template<Ticking declared, BehaviorTreeNode... Children>
+  class BasicFallBack {
   public:
-    FallBack(Children&&... children): children(std::forward<Children>(children)...){}
-    FallBack(FallBack const&) = default;
-    FallBack(FallBack &&) = default;
+    using child_types = std::tuple<Children...>;
+    static constexpr Ticking ticking = ticking_over<declared, Children...>;
+
+    BasicFallBack(Children&&... children): children(std::forward<Children>(children)...){}
+    BasicFallBack(BasicFallBack const&) = default;
+    BasicFallBack(BasicFallBack &&) = default;
+
+    template <typename F>
+    void for_each_child(F&& f) const {
+      std::apply([&](auto const&... child) {(f(child), ...);}, children);
+    }
 
     Result operator()() const {
-      return fall_back<0>();
+      if constexpr (ticking == Ticking::Static) return fall_back<0>();
+      else {
+	Result result = fall_back<0>();
+	if (!tick_suspended()) cursor = {};
+	return result;
+      }
     }
 
   private:
@@ -98,12 +268,73 @@ namespace tickles {
     }
     template<int i>
     Result fall_back() const requires (i < sizeof...(Children)) {
-      Result first_result = std::get<i>(children)();
-      if (first_result == Result::Failed) return fall_back<i+1>();
+      if constexpr (ticking == Ticking::Hooked) {
+	if (i < cursor.next) return fall_back<i+1>();
+      }
+      Result first_result = tick_child<ticking>(std::get<i>(children));
+      if constexpr (ticking == Ticking::Hooked) {
+	if (tick_suspended()) return park(i);
+      }
+      if (first_result == Result::Failed) {
+	if constexpr (ticking == Ticking::Hooked) {
+	  switch (at_boundary<i, sizeof...(Children)>()) {
+	  case Boundary::Abort: return Result::Running;
+	  case Boundary::Suspend: return park(i+1);
+	  case Boundary::Continue: break;
+	  }
+	}
+	return fall_back<i+1>();
+      }
       return first_result;
     }
 
+    Result park(std::uint32_t next) const {
+      cursor.next = next;
+      return Result::Running;
+    }
+
     std::tuple<Children...> children;
+    [[no_unique_address]] mutable cursor_for<ticking> cursor;
+  };
+
+  // The composites trees are written with: static unless a child is hooked.
+  template<BehaviorTreeNode... Children>
+  class Parallel : public BasicParallel<Ticking::Static, Children...> {
+  public:
+    using BasicParallel<Ticking::Static, Children...>::BasicParallel;
+  };
+
+  template<BehaviorTreeNode... Children>
+  class Sequence : public BasicSequence<Ticking::Static, Children...> {
+  public:
+    using BasicSequence<Ticking::Static, Children...>::BasicSequence;
+  };
+
+  template<BehaviorTreeNode... Children>
+  class FallBack : public BasicFallBack<Ticking::Static, Children...> {
+  public:
+    using BasicFallBack<Ticking::Static, Children...>::BasicFallBack;
+  };
+
+  // The same, hooked: for the parts of a tree that observers should see
+  // node by node, or that a tick budget should be able to cut short or a
+  // time slice to park.
+  template<BehaviorTreeNode... Children>
+  class HookedParallel : public BasicParallel<Ticking::Hooked, Children...> {
+  public:
+    using BasicParallel<Ticking::Hooked, Children...>::BasicParallel;
+  };
+
+  template<BehaviorTreeNode... Children>
+  class HookedSequence : public BasicSequence<Ticking::Hooked, Children...> {
+  public:
+    using BasicSequence<Ticking::Hooked, Children...>::BasicSequence;
+  };
+
+  template<BehaviorTreeNode... Children>
+  class HookedFallBack : public BasicFallBack<Ticking::Hooked, Children...> {
+  public:
+    using BasicFallBack<Ticking::Hooked, Children...>::BasicFallBack;
   };
 
 }
@@ -1,15 +1,28 @@
+#include <chrono>
+
 #include "gtest/gtest.h"
 #include "behavior_tree.h"
+#include "clock.h"
+#include "tick_budget.h"
 #include "boost/di.hpp"
 
 using tickles::AlwaysRunning;
 using tickles::AlwaysSucceeded;
 using tickles::AlwaysFailed;
+using tickles::HookedFallBack;
+using tickles::HookedParallel;
+using tickles::HookedSequence;
 using tickles::Parallel;
 using tickles::Sequence;
 using tickles::FallBack;
 
+using tickles::ManualClock;
+using tickles::TickBudget;
+
 using tickles::Result;
+using tickles::Ticking;
+
+using namespace std::chrono_literals;
 
 template <typename T>
 T make() {
@@ -93,3 +106,164 @@ TEST(Nodes, Fallback) {
   EXPECT_EQ((eval<FallBack<AlwaysFailed, AlwaysFailed, AlwaysSucceeded>>()), Result::Succeeded);
 }
 
+
+struct SlowSucceeded {
+  std::shared_ptr<ManualClock> clock;
+  std::shared_ptr<int> ticks;
+  Result operator()() const {
+    clock->advance(10ms);
+    ++*ticks;
+    return Result::Succeeded;
+  }
+};
+
+struct SlowFailed {
+  std::shared_ptr<ManualClock> clock;
+  std::shared_ptr<int> ticks;
+  Result operator()() const {
+    clock->advance(10ms);
+    ++*ticks;
+    return Result::Failed;
+  }
+};
+
+struct SlowRunning {
+  std::shared_ptr<ManualClock> clock;
+  std::shared_ptr<int> ticks;
+  Result operator()() const {
+    clock->advance(10ms);
+    ++*ticks;
+    return Result::Running;
+  }
+};
+
+struct Budget : testing::Test {
+  std::shared_ptr<ManualClock> clock = std::make_shared<ManualClock>();
+  std::shared_ptr<int> ticks = std::make_shared<int>(0);
+  SlowSucceeded succeeded() {return {clock, ticks};}
+  SlowFailed failed() {return {clock, ticks};}
+  SlowRunning running() {return {clock, ticks};}
+
+  // Ticks tree with a suspending budget that runs out after the first leaf.
+  template <typename Tree>
+  Result slice(Tree const& tree, bool expect_suspended) {
+    TickBudget budget(*clock, clock->now() + 5ms, TickBudget::Suspend);
+    Result result = tree();
+    EXPECT_EQ(budget.suspended(), expect_suspended);
+    return result;
+  }
+};
+
+TEST_F(Budget, SequenceStopsAtDeadline) {
+  HookedSequence<SlowSucceeded, SlowSucceeded, SlowSucceeded> tree(succeeded(), succeeded(), succeeded());
+  TickBudget budget(*clock, clock->now() + 15ms);
+  EXPECT_EQ(tree(), Result::Running);
+  EXPECT_EQ(*ticks, 2);
+  ASSERT_TRUE(budget.exhausted());
+  EXPECT_EQ(*budget.overrun()->node, typeid(SlowSucceeded));
+  EXPECT_EQ(budget.overrun()->late_by, 5ms);
+}
+
+TEST_F(Budget, FallBackStopsAtDeadline) {
+  HookedFallBack<SlowFailed, SlowFailed, SlowFailed> tree(failed(), failed(), failed());
+  TickBudget budget(*clock, clock->now() + 5ms);
+  EXPECT_EQ(tree(), Result::Running);
+  EXPECT_EQ(*ticks, 1);
+}
+
+TEST_F(Budget, ParallelStopsAtDeadline) {
+  HookedParallel<SlowSucceeded, SlowSucceeded, SlowSucceeded> tree(succeeded(), succeeded(), succeeded());
+  TickBudget budget(*clock, clock->now() + 15ms);
+  EXPECT_EQ(tree(), Result::Running);
+  EXPECT_EQ(*ticks, 2);
+}
+
+TEST_F(Budget, ResultKeptWhenLastChildOverruns) {
+  HookedSequence<SlowSucceeded, SlowSucceeded> tree(succeeded(), succeeded());
+  TickBudget budget(*clock, clock->now() + 15ms);
+  EXPECT_EQ(tree(), Result::Succeeded);
+  EXPECT_TRUE(budget.exhausted());
+}
+
+TEST_F(Budget, NoBudgetTicksEverything) {
+  HookedSequence<SlowSucceeded, SlowSucceeded, SlowSucceeded> tree(succeeded(), succeeded(), succeeded());
+  EXPECT_EQ(tree(), Result::Succeeded);
+  EXPECT_EQ(*ticks, 3);
+}
+
+TEST_F(Budget, OverrunNamesTheNode) {
+  HookedSequence<SlowSucceeded, SlowSucceeded> tree(succeeded(), succeeded());
+  TickBudget budget(*clock, clock->now() + 5ms);
+  tree();
+  EXPECT_EQ(budget.overrun()->node_name(), "SlowSucceeded");
+}
+
+TEST_F(Budget, SequenceResumesWhereItStopped) {
+  HookedSequence<SlowSucceeded, SlowSucceeded, SlowSucceeded> tree(succeeded(), succeeded(), succeeded());
+  EXPECT_EQ(slice(tree, true), Result::Running);
+  EXPECT_EQ(*ticks, 1);
+  EXPECT_EQ(slice(tree, true), Result::Running);
+  EXPECT_EQ(*ticks, 2);
+  EXPECT_EQ(slice(tree, false), Result::Succeeded);
+  EXPECT_EQ(*ticks, 3);
+
+  EXPECT_EQ(tree(), Result::Succeeded);
+  EXPECT_EQ(*ticks, 6);
+}
+
+TEST_F(Budget, NestedCompositesResume) {
+  HookedFallBack<SlowFailed, HookedParallel<SlowRunning, SlowSucceeded>> tree(
+      failed(), HookedParallel<SlowRunning, SlowSucceeded>(running(), succeeded()));
+  EXPECT_EQ(slice(tree, true), Result::Running);
+  EXPECT_EQ(*ticks, 1);
+  EXPECT_EQ(slice(tree, true), Result::Running);
+  EXPECT_EQ(*ticks, 2);
+  // The Parallel remembers that its first child was still Running.
+  EXPECT_EQ(slice(tree, false), Result::Running);
+  EXPECT_EQ(*ticks, 3);
+
+  EXPECT_EQ(tree(), Result::Running);
+  EXPECT_EQ(*ticks, 6);
+}
+
+TEST_F(Budget, SlicedResultMatchesFullTick) {
+  HookedSequence<SlowSucceeded, HookedFallBack<SlowFailed, SlowSucceeded>, HookedParallel<SlowSucceeded, SlowSucceeded>> tree(
+      succeeded(),
+      HookedFallBack<SlowFailed, SlowSucceeded>(failed(), succeeded()),
+      HookedParallel<SlowSucceeded, SlowSucceeded>(succeeded(), succeeded()));
+  Result full = tree();
+  int calls = 0;
+  Result sliced;
+  do {
+    ++calls;
+    TickBudget budget(*clock, clock->now() + 5ms, TickBudget::Suspend);
+    sliced = tree();
+    if (!budget.suspended()) break;
+  } while (true);
+  EXPECT_EQ(sliced, full);
+  EXPECT_EQ(calls, 5);
+  EXPECT_EQ(*ticks, 10);
+}
+
+// Static composites keep no resume state, and a hooked child makes its
+// parents hooked so that a parked tick can resume through them.
+static_assert(sizeof(Sequence<AlwaysSucceeded, AlwaysFailed>) == 1);
+static_assert(Sequence<AlwaysSucceeded, FallBack<AlwaysFailed>>::ticking == Ticking::Static);
+static_assert(Sequence<AlwaysSucceeded, HookedFallBack<AlwaysFailed>>::ticking == Ticking::Hooked);
+
+TEST_F(Budget, StaticCompositeRunsWhole) {
+  Sequence<SlowSucceeded, SlowSucceeded, SlowSucceeded> tree(succeeded(), succeeded(), succeeded());
+  EXPECT_EQ(slice(tree, false), Result::Succeeded);
+  EXPECT_EQ(*ticks, 3);
+}
+
+TEST_F(Budget, StaticSubtreeRunsWholeUnderHookedParent) {
+  HookedSequence<SlowSucceeded, Sequence<SlowSucceeded, SlowSucceeded>, SlowSucceeded> tree(
+      succeeded(), Sequence<SlowSucceeded, SlowSucceeded>(succeeded(), succeeded()), succeeded());
+  EXPECT_EQ(slice(tree, true), Result::Running);
+  EXPECT_EQ(*ticks, 1);
+  EXPECT_EQ(slice(tree, true), Result::Running);
+  EXPECT_EQ(*ticks, 3);
+  EXPECT_EQ(slice(tree, false), Result::Succeeded);
+  EXPECT_EQ(*ticks, 4);
+}
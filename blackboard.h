@@ -0,0 +1,127 @@
+#ifndef TICKLES_BLACKBOARD_H
+#define TICKLES_BLACKBOARD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+#include "autonomy_scope.h"
+#include "checkpoint.h"
+#include "input.h"
+#include "type_name.h"
+
+namespace tickles {
+
+  namespace detail {
+    template <typename T, typename... Ts>
+    constexpr std::size_t index_of() {
+      constexpr bool matches[] = {std::is_same_v<T, Ts>...};
+      for (std::size_t i = 0; i < sizeof...(Ts); ++i) if (matches[i]) return i;
+      return sizeof...(Ts);
+    }
+
+    template <typename... Ts>
+    constexpr bool all_distinct() {
+      return []<std::size_t... i>(std::index_sequence<i...>) {
+	return ((index_of<Ts, Ts...>() == i) && ...);
+      }(std::index_sequence_for<Ts...>{});
+    }
+  }
+
+  // All the inputs of an Autonomy in one block, keyed by type.
+  //
+  // Every field is an Input<Field> stored inline, so the values of a whole
+  // set of inputs take a single allocation, and fields that are read
+  // together share cache lines instead of being scattered over the heap.
+  // Each field keeps its own version. (Publishing adds an entry per field to
+  // the AutonomyScope's table, once, when the Autonomy is built.)
+  //
+  // Held by shared_ptr in an Autonomy's data, a Blackboard publishes its
+  // fields into the AutonomyScope as soon as it is created: leaves asking for
+  // Input<Field> const&, Field const& or std::shared_ptr<Input<Field>> (as
+  // Memoize does) get a view into the blackboard rather than an object of
+  // their own. It therefore has to come before the tree in the data, and
+  // before anything else that resolves one of its fields; publishing throws
+  // std::logic_error if a field was resolved first, as that would leave two
+  // copies of the input.
+  template <typename... Fields>
+  class alignas(64) Blackboard {
+    static_assert(detail::all_distinct<Fields...>(), "Blackboard fields are keyed by type and must be distinct");
+
+  public:
+    template <typename Field>
+    static constexpr std::size_t index_of = detail::index_of<Field, Fields...>();
+
+    template <typename Field>
+    static constexpr bool has = index_of<Field> < sizeof...(Fields);
+
+    Blackboard() = default;
+    Blackboard(Blackboard const&) = delete;
+    Blackboard(Blackboard &&) = delete;
+
+    template <typename Field> requires has<Field>
+    Input<Field>& input() {return std::get<index_of<Field>>(_fields);}
+
+    template <typename Field> requires has<Field>
+    Input<Field> const& input() const {return std::get<index_of<Field>>(_fields);}
+
+    template <typename Field, typename U> requires has<Field>
+    void set(U&& u) {input<Field>().set(std::forward<U>(u));}
+
+    template <typename Field> requires has<Field>
+    Field const& get() const {return input<Field>().get();}
+
+    template <typename Field> requires has<Field>
+    std::uint64_t version() const {return input<Field>().version();}
+
+    void publish(AutonomyScope& scope, std::shared_ptr<Blackboard> const& self) {
+      (publish_field<Fields>(scope, self), ...);
+    }
+
+  private:
+    template <typename Field>
+    void publish_field(AutonomyScope& scope, std::shared_ptr<Blackboard> const& self) {
+      Input<Field>& field = input<Field>();
+      // Leaves get the value as Field const&; the const_cast only lets the
+      // scope hold it next to everything else.
+      bool fresh =
+	scope.adopt(std::shared_ptr<Input<Field>>(self, &field)) &
+	scope.adopt(std::shared_ptr<Field>(self, const_cast<Field*>(&field.get())));
+      if (!fresh) {
+	throw std::logic_error("Blackboard field " + type_name(typeid(Field)) + " was resolved before the Blackboard");
+      }
+    }
+
+    std::tuple<Input<Fields>...> _fields;
+  };
+
+  // Saves the fields that are Checkpointable, in order.
+  template <typename... Fields>
+  struct checkpoint_traits<Blackboard<Fields...>> {
+    static void save(CheckpointWriter& writer, Blackboard<Fields...> const& board) {
+      (save_field<Fields>(writer, board), ...);
+    }
+    static void load(CheckpointReader& reader, Blackboard<Fields...>& board) {
+      (load_field<Fields>(reader, board), ...);
+    }
+
+  private:
+    template <typename Field>
+    static void save_field(CheckpointWriter& writer, Blackboard<Fields...> const& board) {
+      if constexpr (Checkpointable<Field>) writer.put(board.template input<Field>());
+    }
+    template <typename Field>
+    static void load_field(CheckpointReader& reader, Blackboard<Fields...>& board) {
+      if constexpr (Checkpointable<Field>) reader.get(board.template input<Field>());
+    }
+  };
+
+} // namespace tickles
+
+#endif
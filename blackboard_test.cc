@@ -0,0 +1,124 @@
+#include <memory>
+#include <stdexcept>
+
+#include "gtest/gtest.h"
+#include "autonomy.h"
+#include "behavior_tree.h"
+#include "blackboard.h"
+#include "decorators.h"
+#include "input.h"
+#include "mutable.h"
+
+using tickles::AlwaysSucceeded;
+using tickles::Autonomy;
+using tickles::Blackboard;
+using tickles::Input;
+using tickles::Memoize;
+using tickles::Mutable;
+using tickles::Mutator;
+using tickles::Result;
+using tickles::Sequence;
+
+namespace {
+
+  struct Speed {
+    int speed = 0;
+  };
+
+  struct Heading {
+    double degrees = 0;
+  };
+
+  using Inputs = Blackboard<Speed, Heading>;
+
+  TEST(Blackboard, FieldsAreKeyedByType) {
+    Inputs inputs;
+    inputs.set<Speed>(Speed{3});
+    inputs.set<Heading>(Heading{90});
+    EXPECT_EQ(inputs.get<Speed>().speed, 3);
+    EXPECT_EQ(inputs.get<Heading>().degrees, 90);
+    static_assert(Inputs::index_of<Heading> == 1);
+    static_assert(!Inputs::has<int>);
+  }
+
+  TEST(Blackboard, VersionsArePerField) {
+    Inputs inputs;
+    inputs.set<Speed>(Speed{1});
+    inputs.set<Speed>(Speed{2});
+    EXPECT_EQ(inputs.version<Speed>(), 2);
+    EXPECT_EQ(inputs.version<Heading>(), 0);
+  }
+
+  TEST(Blackboard, StoredInlineAndAligned) {
+    static_assert(alignof(Inputs) == 64);
+    static_assert(sizeof(Inputs) == 64);
+    Inputs inputs;
+    auto* begin = reinterpret_cast<char const*>(&inputs);
+    auto* speed = reinterpret_cast<char const*>(&inputs.get<Speed>());
+    EXPECT_LT(speed - begin, 64);
+  }
+
+  struct Drive {
+    Speed const& speed;
+    Mutator<int> out;
+
+    Result operator()() const {
+      out.set(speed.speed);
+      return Result::Succeeded;
+    }
+  };
+
+  struct Steer {
+    Input<Heading> const& heading;
+    Mutator<double> out;
+
+    Result operator()() const {
+      out.set(heading.get().degrees);
+      return Result::Succeeded;
+    }
+  };
+
+  struct Tree : Sequence<Drive, Memoize<Steer, Input<Heading>>> {};
+
+  struct Data {
+    std::shared_ptr<Inputs> inputs;
+    std::shared_ptr<Mutable<int>> speed;
+    std::shared_ptr<Mutable<double>> heading;
+  };
+
+  struct TestAutonomy : Autonomy<Data, Tree> {};
+
+  TEST(Blackboard, LeavesReadFromTheBlackboard) {
+    TestAutonomy autonomy;
+    Inputs& inputs = *autonomy.data().inputs;
+    inputs.set<Speed>(Speed{4});
+    inputs.set<Heading>(Heading{45});
+    autonomy.sync();
+    EXPECT_EQ(autonomy.data().speed->get(), 4);
+    EXPECT_EQ(autonomy.data().heading->get(), 45);
+
+    inputs.set<Heading>(Heading{30});
+    autonomy.sync();
+    EXPECT_EQ(autonomy.data().heading->get(), 30);
+  }
+
+  TEST(Blackboard, OnePerAutonomy) {
+    TestAutonomy a, b;
+    a.data().inputs->set<Speed>(Speed{1});
+    b.data().inputs->set<Speed>(Speed{2});
+    a.sync();
+    b.sync();
+    EXPECT_EQ(a.data().speed->get(), 1);
+    EXPECT_EQ(b.data().speed->get(), 2);
+  }
+
+  struct LateData {
+    std::shared_ptr<Input<Speed>> speed;
+    std::shared_ptr<Inputs> inputs;
+  };
+
+  TEST(Blackboard, ResolvedAfterItsFields) {
+    EXPECT_THROW((Autonomy<LateData, AlwaysSucceeded>()), std::logic_error);
+  }
+
+}
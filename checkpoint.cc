@@ -0,0 +1,88 @@
+#include "checkpoint.h"
+
+namespace tickles {
+
+namespace {
+
+  constexpr std::uint32_t kMagic = 0x504b4354; // "TCKP"
+  constexpr std::uint32_t kFormat = 1;
+
+  struct Header {
+    std::uint32_t magic;
+    std::uint32_t format;
+    std::uint64_t size;
+    std::uint64_t checksum;
+  };
+
+  std::uint64_t fnv1a(std::span<std::byte const> data) {
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for (std::byte b : data) {
+      hash ^= static_cast<std::uint64_t>(b);
+      hash *= 0x100000001b3;
+    }
+    return hash;
+  }
+
+} // namespace
+
+std::size_t CheckpointWriter::begin_entry(std::uint64_t key) {
+  write(&key, sizeof(key));
+  std::size_t at = _size;
+  std::uint32_t length = 0;
+  write(&length, sizeof(length));
+  return at;
+}
+
+void CheckpointWriter::end_entry(std::size_t at) {
+  if (_overflowed) return;
+  std::uint32_t length = static_cast<std::uint32_t>(_size - at - sizeof(length));
+  std::memcpy(_buffer.data() + at, &length, sizeof(length));
+}
+
+std::optional<CheckpointReader::Entry> CheckpointReader::next_entry() {
+  Entry entry;
+  std::uint32_t length;
+  if (done() || !read(&entry.key, sizeof(entry.key)) || !read(&length, sizeof(length))) return std::nullopt;
+  if (length > _data.size() - _offset) {
+    _failed = true;
+    return std::nullopt;
+  }
+  entry.data = _data.subspan(_offset, length);
+  _offset += length;
+  return entry;
+}
+
+std::uint64_t checkpoint_key(std::type_info const& type) {
+  char const* name = type.name();
+  return fnv1a(std::as_bytes(std::span(name, std::strlen(name))));
+}
+
+std::size_t begin_checkpoint(CheckpointWriter& writer) {
+  std::size_t at = writer.size();
+  Header header{};
+  writer.write(&header, sizeof(header));
+  return at;
+}
+
+std::size_t end_checkpoint(CheckpointWriter& writer, std::size_t at) {
+  if (writer.overflowed()) return 0;
+  std::span<std::byte> buffer = writer.buffer();
+  std::size_t begin = at + sizeof(Header);
+  std::span<std::byte const> entries = buffer.subspan(begin, writer.size() - begin);
+  Header header{kMagic, kFormat, entries.size(), fnv1a(entries)};
+  std::memcpy(buffer.data() + at, &header, sizeof(header));
+  return writer.size() - at;
+}
+
+std::optional<std::span<std::byte const>> checkpoint_entries(std::span<std::byte const> snapshot) {
+  Header header;
+  if (snapshot.size() < sizeof(header)) return std::nullopt;
+  std::memcpy(&header, snapshot.data(), sizeof(header));
+  if (header.magic != kMagic || header.format != kFormat) return std::nullopt;
+  if (header.size > snapshot.size() - sizeof(header)) return std::nullopt;
+  std::span<std::byte const> entries = snapshot.subspan(sizeof(header), header.size);
+  if (fnv1a(entries) != header.checksum) return std::nullopt;
+  return entries;
+}
+
+} // namespace tickles
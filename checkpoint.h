@@ -0,0 +1,176 @@
+#ifndef TICKLES_CHECKPOINT_H
+#define TICKLES_CHECKPOINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <typeinfo>
+
+namespace tickles {
+
+  // Binary snapshots of an Autonomy's state, for restarting without having
+  // to reconverge.
+  //
+  // A snapshot is a header followed by entries, each a 64 bit key, a 32 bit
+  // length and that many bytes. Keys are derived from type names, so a
+  // snapshot can only be restored by the same build that wrote it; entries
+  // whose key is unknown are skipped and objects without an entry keep their
+  // defaults.
+
+  class CheckpointWriter;
+  class CheckpointReader;
+
+  // Specialise for each value type that should survive a restart:
+  //
+  //   template <> struct checkpoint_traits<Position> : trivial_checkpoint<Position> {};
+  //
+  // or with save(CheckpointWriter&, T const&) and load(CheckpointReader&, T&)
+  // of its own. Arithmetic and enum types are covered already.
+  template <typename T>
+  struct checkpoint_traits;
+
+  template <typename T>
+  concept Checkpointable = requires (CheckpointWriter& writer, CheckpointReader& reader, T const& in, T& out) {
+    checkpoint_traits<T>::save(writer, in);
+    checkpoint_traits<T>::load(reader, out);
+  };
+
+  // Tree nodes keep their memory in mutable members, so they opt in with
+  // const members instead of a trait.
+  template <typename Node>
+  concept NodeWithMemory = requires (Node const& node, CheckpointWriter& writer, CheckpointReader& reader) {
+    node.save_memory(writer);
+    node.restore_memory(reader);
+  };
+
+  class CheckpointWriter {
+  public:
+    explicit CheckpointWriter(std::span<std::byte> buffer) : _buffer(buffer) {}
+
+    void write(void const* data, std::size_t size) {
+      if (size > _buffer.size() - _size) {
+	_overflowed = true;
+	return;
+      }
+      std::memcpy(_buffer.data() + _size, data, size);
+      _size += size;
+    }
+
+    template <Checkpointable T>
+    void put(T const& value) {checkpoint_traits<T>::save(*this, value);}
+
+    // Entries nest: begin_entry() returns where the length goes, and
+    // end_entry() fills it in.
+    std::size_t begin_entry(std::uint64_t key);
+    void end_entry(std::size_t at);
+
+    // Drops whatever was written after the first size bytes.
+    void rewind(std::size_t size) {
+      if (size < _size) _size = size;
+    }
+
+    std::size_t size() const {return _size;}
+    bool overflowed() const {return _overflowed;}
+    std::span<std::byte> buffer() const {return _buffer;}
+
+  private:
+    std::span<std::byte> _buffer;
+    std::size_t _size = 0;
+    bool _overflowed = false;
+  };
+
+  class CheckpointReader {
+  public:
+    explicit CheckpointReader(std::span<std::byte const> data) : _data(data) {}
+
+    // Fails, and leaves out untouched, if fewer than size bytes are left.
+    bool read(void* out, std::size_t size) {
+      if (size > _data.size() - _offset) {
+	_failed = true;
+	return false;
+      }
+      std::memcpy(out, _data.data() + _offset, size);
+      _offset += size;
+      return true;
+    }
+
+    // The next size bytes, without copying them; empty if fewer are left.
+    std::span<std::byte const> take(std::size_t size) {
+      if (size > _data.size() - _offset) {
+	_failed = true;
+	return {};
+      }
+      auto taken = _data.subspan(_offset, size);
+      _offset += size;
+      return taken;
+    }
+
+    template <Checkpointable T>
+    bool get(T& value) {
+      checkpoint_traits<T>::load(*this, value);
+      return !_failed;
+    }
+
+    // Reads the next entry, if there is one left.
+    struct Entry {
+      std::uint64_t key;
+      std::span<std::byte const> data;
+    };
+    std::optional<Entry> next_entry();
+
+    bool failed() const {return _failed;}
+    bool done() const {return _offset == _data.size();}
+
+  private:
+    std::span<std::byte const> _data;
+    std::size_t _offset = 0;
+    bool _failed = false;
+  };
+
+  template <typename T>
+  struct trivial_checkpoint {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static void save(CheckpointWriter& writer, T const& value) {writer.write(&value, sizeof(T));}
+    static void load(CheckpointReader& reader, T& value) {reader.read(&value, sizeof(T));}
+  };
+
+  template <typename T>
+    requires std::is_arithmetic_v<T> || std::is_enum_v<T>
+  struct checkpoint_traits<T> : trivial_checkpoint<T> {};
+
+  // FNV-1a of the type's name: the same for the same build.
+  std::uint64_t checkpoint_key(std::type_info const& type);
+
+  // Header and checksum around the entries, so that a torn or stale file is
+  // refused rather than half restored.
+  std::size_t begin_checkpoint(CheckpointWriter& writer);
+  // Returns the size of the finished snapshot, or 0 if it did not fit.
+  std::size_t end_checkpoint(CheckpointWriter& writer, std::size_t at);
+  // The entries of a snapshot written by end_checkpoint(), if it is intact.
+  std::optional<std::span<std::byte const>> checkpoint_entries(std::span<std::byte const> snapshot);
+
+  // Saves or restores the memory of every node of a tree that has some,
+  // depth first. Composites and decorators expose their children through
+  // for_each_child().
+  template <typename Node>
+  void save_tree(CheckpointWriter& writer, Node const& node) {
+    if constexpr (NodeWithMemory<Node>) node.save_memory(writer);
+    if constexpr (requires {node.for_each_child([](auto const&) {});}) {
+      node.for_each_child([&](auto const& child) {save_tree(writer, child);});
+    }
+  }
+
+  template <typename Node>
+  void restore_tree(CheckpointReader& reader, Node const& node) {
+    if constexpr (NodeWithMemory<Node>) node.restore_memory(reader);
+    if constexpr (requires {node.for_each_child([](auto const&) {});}) {
+      node.for_each_child([&](auto const& child) {restore_tree(reader, child);});
+    }
+  }
+
+} // namespace tickles
+
+#endif
@@ -0,0 +1,96 @@
+#include "checkpoint_file.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+
+namespace tickles {
+
+namespace {
+
+  std::size_t page_size() {
+    return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  }
+
+  std::size_t round_up(std::size_t n, std::size_t to) {
+    return (n + to - 1) / to * to;
+  }
+
+} // namespace
+
+CheckpointFile::CheckpointFile(std::string const& path, std::size_t capacity) {
+  // Slots start on a page, so that each can be written back on its own.
+  _slot_size = round_up(payload_offset() + capacity, page_size());
+  _fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (_fd < 0) return;
+  struct stat st;
+  if (::fstat(_fd, &st) != 0) return;
+  _size = 2 * _slot_size;
+  if (static_cast<std::size_t>(st.st_size) != _size) {
+    // A file laid out for another capacity holds nothing this one can use.
+    if (::ftruncate(_fd, 0) != 0 || ::ftruncate(_fd, static_cast<off_t>(_size)) != 0) return;
+  }
+  void* data = ::mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+  if (data == MAP_FAILED) return;
+  _data = static_cast<std::byte*>(data);
+  for (std::size_t i = 0; i < 2; ++i) {
+    if (intact(i) && header(i).generation > _generation) {
+      _newest = i;
+      _generation = header(i).generation;
+    }
+  }
+}
+
+CheckpointFile::~CheckpointFile() {
+  if (_data) ::munmap(_data, _size);
+  if (_fd >= 0) ::close(_fd);
+}
+
+CheckpointFile::SlotHeader CheckpointFile::header(std::size_t i) const {
+  SlotHeader header;
+  std::memcpy(&header, slot(i), sizeof(header));
+  return header;
+}
+
+std::size_t CheckpointFile::payload_offset() {
+  return round_up(sizeof(SlotHeader), alignof(std::max_align_t));
+}
+
+bool CheckpointFile::intact(std::size_t i) const {
+  SlotHeader h = header(i);
+  if (h.generation == 0 || h.size > _slot_size - payload_offset()) return false;
+  return checkpoint_entries({slot(i) + payload_offset(), h.size}).has_value();
+}
+
+std::span<std::byte> CheckpointFile::buffer() {
+  if (!_data) return {};
+  std::size_t next = _generation ? 1 - _newest : 0;
+  return {slot(next) + payload_offset(), _slot_size - payload_offset()};
+}
+
+bool CheckpointFile::commit(std::size_t size) {
+  if (!_data || size == 0 || size > _slot_size - payload_offset()) return false;
+  std::size_t next = _generation ? 1 - _newest : 0;
+  // The snapshot reaches the disk before the header that makes it the
+  // newest. A crash before that leaves the slot with its old generation, or
+  // with bytes that fail their checksum, and the other slot in charge.
+  if (::msync(slot(next), _slot_size, MS_SYNC) != 0) return false;
+  SlotHeader header{_generation + 1, size};
+  std::memcpy(slot(next), &header, sizeof(header));
+  if (::msync(slot(next), page_size(), MS_SYNC) != 0) return false;
+  _newest = next;
+  ++_generation;
+  return true;
+}
+
+std::span<std::byte const> CheckpointFile::snapshot() const {
+  if (!_data || !_generation) return {};
+  return {slot(_newest) + payload_offset(), header(_newest).size};
+}
+
+} // namespace tickles
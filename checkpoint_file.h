@@ -0,0 +1,66 @@
+#ifndef TICKLES_CHECKPOINT_FILE_H
+#define TICKLES_CHECKPOINT_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace tickles {
+
+  // A file mapped into memory that snapshots are written into in place.
+  //
+  // It holds two slots, each stamped with a generation once the snapshot in
+  // it has reached the disk. buffer() is always the slot not holding the
+  // newest snapshot, so a write torn by a crash only ever damages the older
+  // one, and snapshot() falls back to whichever intact one is newer:
+  //
+  //   file.commit(autonomy.checkpoint(file.buffer()));
+  //   ...
+  //   autonomy.restore(file.snapshot());
+  class CheckpointFile {
+  public:
+    // Opens path, creating it with room for two snapshots of capacity bytes
+    // if it does not exist or is smaller. Check is_open().
+    CheckpointFile(std::string const& path, std::size_t capacity);
+    CheckpointFile(CheckpointFile const&) = delete;
+    CheckpointFile(CheckpointFile &&) = delete;
+    ~CheckpointFile();
+
+    bool is_open() const {return _data != nullptr;}
+
+    // Where to write the next snapshot.
+    std::span<std::byte> buffer();
+
+    // Makes the first size bytes of buffer() the newest snapshot, after
+    // writing them back to the disk. Returns false, keeping the previous
+    // snapshot, if size is 0 (as checkpoint() returns when it does not fit)
+    // or the write-back failed.
+    bool commit(std::size_t size);
+
+    // The newest intact snapshot, or an empty span if there is none.
+    std::span<std::byte const> snapshot() const;
+
+  private:
+    struct SlotHeader {
+      std::uint64_t generation;
+      std::uint64_t size;
+    };
+
+    std::byte* slot(std::size_t i) const {return _data + i * _slot_size;}
+    SlotHeader header(std::size_t i) const;
+    static std::size_t payload_offset();
+    bool intact(std::size_t i) const;
+
+    std::byte* _data = nullptr;
+    std::size_t _size = 0;
+    std::size_t _slot_size = 0;
+    // The slot holding the newest intact snapshot, if any.
+    std::size_t _newest = 0;
+    std::uint64_t _generation = 0;
+    int _fd = -1;
+  };
+
+} // namespace tickles
+
+#endif
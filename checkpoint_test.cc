@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "any_node.h"
+#include "autonomy.h"
+#include "behavior_tree.h"
+#include "blackboard.h"
+#include "checkpoint.h"
+#include "checkpoint_file.h"
+#include "input.h"
+#include "mutable.h"
+#include "reordering_parallel.h"
+
+using tickles::AnyNode;
+using tickles::Autonomy;
+using tickles::BasicReorderingParallel;
+using tickles::Blackboard;
+using tickles::CheckpointFile;
+using tickles::CheckpointReader;
+using tickles::CheckpointWriter;
+using tickles::Input;
+using tickles::Mutable;
+using tickles::Mutator;
+using tickles::Result;
+using tickles::Sequence;
+
+namespace {
+
+  struct Speed {
+    int value = 0;
+  };
+
+  struct Latched {
+    bool latched = false;
+    bool operator==(Latched const&) const = default;
+  };
+
+  // Not checkpointed: comes back as the default.
+  struct Scratch {
+    int value = 0;
+    bool operator==(Scratch const&) const = default;
+  };
+
+}
+
+template <> struct tickles::checkpoint_traits<Speed> : tickles::trivial_checkpoint<Speed> {};
+template <> struct tickles::checkpoint_traits<Latched> : tickles::trivial_checkpoint<Latched> {};
+
+namespace {
+
+  // Latches once the speed is too high, until it drops to zero.
+  struct Overspeed {
+    Speed const& speed;
+    Mutator<Latched> latch;
+    Mutator<Scratch> scratch;
+
+    Result operator()() const {
+      if (speed.value > 10) latch.set(Latched{true});
+      if (speed.value == 0) latch.set(Latched{false});
+      scratch.set(Scratch{speed.value});
+      return latch.get().latched ? Result::Failed : Result::Succeeded;
+    }
+  };
+
+  struct Tree : Sequence<Overspeed> {};
+
+  struct Data {
+    std::shared_ptr<Blackboard<Speed>> inputs;
+    std::shared_ptr<Input<int>> limit;
+    std::shared_ptr<const Mutable<Latched>> latch;
+    std::shared_ptr<const Mutable<Scratch>> scratch;
+  };
+
+  struct TestAutonomy : Autonomy<Data, Tree> {
+    void speed(int value) {
+      data().inputs->set<Speed>(Speed{value});
+      sync();
+    }
+  };
+
+  std::vector<std::byte> snapshot_of(TestAutonomy const& autonomy) {
+    std::vector<std::byte> buffer(4096);
+    buffer.resize(autonomy.checkpoint(buffer));
+    return buffer;
+  }
+
+}
+
+TEST(Checkpoint, RestoresCommittedState) {
+  TestAutonomy before;
+  before.data().limit->set(7);
+  before.speed(20);
+  before.speed(5);
+  ASSERT_TRUE(before.data().latch->get().latched);
+  auto snapshot = snapshot_of(before);
+  ASSERT_GT(snapshot.size(), 0);
+
+  TestAutonomy after;
+  ASSERT_TRUE(after.restore(snapshot));
+  EXPECT_TRUE(after.data().latch->get().latched);
+  EXPECT_EQ(after.data().inputs->get<Speed>().value, 5);
+  EXPECT_EQ(after.data().limit->get(), 7);
+  EXPECT_EQ(after.data().scratch->get().value, 0);
+
+  // The latch carries on as if there had been no restart.
+  after.speed(5);
+  EXPECT_TRUE(after.data().latch->get().latched);
+  after.speed(0);
+  EXPECT_FALSE(after.data().latch->get().latched);
+}
+
+TEST(Checkpoint, RefusesDamagedSnapshot) {
+  TestAutonomy before;
+  before.speed(20);
+  auto snapshot = snapshot_of(before);
+  snapshot.back() ^= std::byte{1};
+
+  TestAutonomy after;
+  EXPECT_FALSE(after.restore(snapshot));
+  EXPECT_FALSE(after.data().latch->get().latched);
+  EXPECT_FALSE(after.restore({}));
+}
+
+TEST(Checkpoint, ReportsBufferTooSmall) {
+  TestAutonomy autonomy;
+  std::vector<std::byte> buffer(16);
+  EXPECT_EQ(autonomy.checkpoint(buffer), 0);
+}
+
+TEST(Checkpoint, RollsBackWhenAnEntryDoesNotFit) {
+  TestAutonomy before;
+  before.speed(20);
+  // The latch is restored before the limit turns out to be cut short.
+  std::vector<std::byte> snapshot(256);
+  CheckpointWriter writer(snapshot);
+  std::size_t at = tickles::begin_checkpoint(writer);
+  std::size_t latch = writer.begin_entry(tickles::checkpoint_key(typeid(Mutable<Latched>)));
+  writer.put(Latched{true});
+  writer.end_entry(latch);
+  std::size_t limit = writer.begin_entry(tickles::checkpoint_key(typeid(Input<int>)));
+  writer.put(std::uint8_t{7});
+  writer.end_entry(limit);
+  snapshot.resize(tickles::end_checkpoint(writer, at));
+
+  TestAutonomy after;
+  after.data().limit->set(3);
+  EXPECT_FALSE(after.restore(snapshot));
+  EXPECT_FALSE(after.data().latch->get().latched);
+  EXPECT_EQ(after.data().limit->get(), 3);
+}
+
+TEST(Checkpoint, ThroughMappedFile) {
+  auto path = std::filesystem::path(testing::TempDir()) / "tickles_checkpoint_test";
+  std::filesystem::remove(path);
+  {
+    CheckpointFile file(path.string(), 4096);
+    ASSERT_TRUE(file.is_open());
+    EXPECT_TRUE(file.snapshot().empty());
+    TestAutonomy before;
+    before.speed(20);
+    ASSERT_TRUE(file.commit(before.checkpoint(file.buffer())));
+  }
+  CheckpointFile file(path.string(), 4096);
+  ASSERT_TRUE(file.is_open());
+  TestAutonomy after;
+  EXPECT_TRUE(after.restore(file.snapshot()));
+  EXPECT_TRUE(after.data().latch->get().latched);
+  std::filesystem::remove(path);
+}
+
+TEST(Checkpoint, FileKeepsLastSnapshotThroughTornWrite) {
+  auto path = std::filesystem::path(testing::TempDir()) / "tickles_checkpoint_torn_test";
+  std::filesystem::remove(path);
+  {
+    CheckpointFile file(path.string(), 4096);
+    TestAutonomy first;
+    first.speed(20);
+    ASSERT_TRUE(file.commit(first.checkpoint(file.buffer())));
+    TestAutonomy second;
+    second.speed(20);
+    second.speed(0);
+    ASSERT_TRUE(file.commit(second.checkpoint(file.buffer())));
+    // A third write dies halfway, over the first snapshot.
+    TestAutonomy third;
+    std::size_t size = third.checkpoint(file.buffer());
+    ASSERT_GT(size, 0);
+    std::fill(file.buffer().begin() + size / 2, file.buffer().end(), std::byte{0xff});
+    EXPECT_FALSE(file.commit(0));
+  }
+  CheckpointFile file(path.string(), 4096);
+  TestAutonomy after;
+  after.data().limit->set(1);
+  ASSERT_TRUE(after.restore(file.snapshot()));
+  EXPECT_FALSE(after.data().latch->get().latched);
+  EXPECT_EQ(after.data().limit->get(), 0);
+  std::filesystem::remove(path);
+}
+
+namespace {
+
+  template <int id, int fail_every>
+  struct Check {
+    static constexpr bool pure = true;
+    static constexpr double tick_cost = 1;
+    std::shared_ptr<int> tick;
+    Result operator()() const {return *tick % fail_every == 0 ? Result::Failed : Result::Succeeded;}
+  };
+
+  using Learner = BasicReorderingParallel<10, 1, Check<0, 50>, Check<1, 2>>;
+
+  Learner make_learner(std::shared_ptr<int> tick) {
+    return Learner(Check<0, 50>{tick}, Check<1, 2>{tick});
+  }
+
+}
+
+TEST(Checkpoint, KeepsNodeMemory) {
+  auto tick = std::make_shared<int>(1);
+  Learner trained = make_learner(tick);
+  for (; *tick <= 10; ++*tick) trained();
+  ASSERT_EQ(trained.order()[0], 1);
+
+  std::vector<std::byte> buffer(256);
+  CheckpointWriter writer(buffer);
+  tickles::save_tree(writer, AnyNode(Sequence<Learner>(std::move(trained))));
+  ASSERT_FALSE(writer.overflowed());
+
+  AnyNode fresh(Sequence<Learner>(make_learner(tick)));
+  CheckpointReader reader{std::span(buffer).first(writer.size())};
+  tickles::restore_tree(reader, fresh);
+  EXPECT_TRUE(reader.done());
+
+  Learner other = make_learner(tick);
+  CheckpointReader again{std::span(buffer).first(writer.size())};
+  tickles::restore_tree(again, other);
+  EXPECT_EQ(other.order()[0], 1);
+}
+
+TEST(Checkpoint, SkipsInvalidOrderButReadsPastIt) {
+  auto tick = std::make_shared<int>(1);
+  Learner trained = make_learner(tick);
+  for (; *tick <= 10; ++*tick) trained();
+  ASSERT_EQ(trained.order()[0], 1);
+
+  std::vector<std::byte> buffer(256);
+  CheckpointWriter writer(buffer);
+  tickles::save_tree(writer, trained);
+  tickles::save_tree(writer, trained);
+  // The first Learner's order names child 1 twice.
+  std::uint32_t twice[] = {1, 1};
+  std::memcpy(buffer.data(), twice, sizeof(twice));
+
+  Learner first = make_learner(tick), second = make_learner(tick);
+  CheckpointReader reader{std::span(buffer).first(writer.size())};
+  tickles::restore_tree(reader, first);
+  tickles::restore_tree(reader, second);
+  EXPECT_TRUE(reader.done());
+  EXPECT_FALSE(reader.failed());
+  EXPECT_EQ(first.order()[0], 0);
+  EXPECT_EQ(second.order()[0], 1);
+}
@@ -0,0 +1,18 @@
+#include "clock.h"
+
+#include <cerrno>
+#include <ctime>
+
+namespace tickles {
+
+void SteadyClock::sleep_until(time_point t) {
+  // libstdc++ implements steady_clock on top of CLOCK_MONOTONIC.
+  auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch());
+  if (since_epoch.count() < 0) return;
+  timespec deadline{
+    .tv_sec = static_cast<time_t>(since_epoch.count() / 1'000'000'000),
+    .tv_nsec = static_cast<long>(since_epoch.count() % 1'000'000'000)};
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {}
+}
+
+} // namespace tickles
@@ -0,0 +1,51 @@
+#ifndef TICKLES_CLOCK_H
+#define TICKLES_CLOCK_H
+
+#include <chrono>
+#include <concepts>
+
+namespace tickles {
+
+  // Clocks are injected as std::shared_ptr<ClockT> so that tests can swap the
+  // steady clock for one they drive by hand.
+  template <typename T>
+  concept TickClock = requires (T const& c) {
+    {c.now()} -> std::same_as<typename T::time_point>;
+  };
+
+  // A clock that can also block the calling thread until a given time.
+  template <typename T>
+  concept SleepingClock = TickClock<T> && requires (T& c, typename T::time_point t) {
+    c.sleep_until(t);
+  };
+
+  class SteadyClock {
+  public:
+    using duration = std::chrono::steady_clock::duration;
+    using time_point = std::chrono::steady_clock::time_point;
+
+    time_point now() const {return std::chrono::steady_clock::now();}
+
+    // Absolute-deadline clock_nanosleep on CLOCK_MONOTONIC, so that wakeups
+    // do not drift with the time spent between sleeps.
+    void sleep_until(time_point t);
+  };
+
+  class ManualClock {
+  public:
+    using duration = std::chrono::steady_clock::duration;
+    using time_point = std::chrono::steady_clock::time_point;
+
+    time_point now() const {return _now;}
+
+    void set(time_point t) {_now = t;}
+    void advance(duration d) {_now += d;}
+    void sleep_until(time_point t) {if (t > _now) _now = t;}
+
+  private:
+    time_point _now{};
+  };
+
+} // namespace tickles
+
+#endif
@@ -0,0 +1,194 @@
+#ifndef TICKLES_CONDITION_H
+#define TICKLES_CONDITION_H
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <span>
+#include <tuple>
+#include <utility>
+
+#include "behavior_tree.h"
+#include "result_lanes.h"
+
+namespace tickles {
+
+  // Leaves that only test fields of what they read, written as types:
+  //
+  //   using LowBattery = LessEqual<&Charge::charge, 0.2>;
+  //   using Busy = And<Less<&Position::position, 500>, Not<LowBattery>>;
+  //
+  // A comparison takes the struct its member belongs to by const& (which is
+  // how Boost.DI wires it), and And, Or and Not take their operands like
+  // composites take children. Operands are always all evaluated and joined
+  // with & and |, and the bool becomes a Result arithmetically, so a
+  // condition compiles to straight-line code with no branches to mispredict.
+  //
+  // The same types evaluate many agents at once with evaluate(), from one
+  // column per struct type and into ResultLanes.
+
+  template <typename C>
+  concept Condition = BehaviorTreeNode<C> && requires (C const& c) {
+    {c.test()} -> std::same_as<bool>;
+  };
+
+  // Succeeded for true, Failed for false, which this takes to be one apart.
+  static_assert(static_cast<int>(Result::Failed) - 1 == static_cast<int>(Result::Succeeded));
+  inline Result condition_result(bool b) {
+    return static_cast<Result>(static_cast<int>(Result::Failed) - b);
+  }
+
+  namespace condition {
+    template <typename M>
+    struct member_pointer;
+    template <typename T, typename S>
+    struct member_pointer<T S::*> {
+      using source = S;
+      using value = T;
+    };
+
+    template <auto member>
+    using source_t = typename member_pointer<decltype(member)>::source;
+
+    template <typename... Sources>
+    using Columns = std::tuple<std::span<Sources const>...>;
+  }
+
+  template <auto member, typename Op, auto bound>
+  class Comparison {
+  public:
+    using source_type = condition::source_t<member>;
+    static constexpr bool pure = true;
+
+    explicit Comparison(source_type const& source) : _source(source) {}
+    Comparison(Comparison const&) = default;
+    Comparison(Comparison &&) = default;
+
+    static bool test(source_type const& source) {return Op{}(source.*member, bound);}
+    bool test() const {return test(_source);}
+    Result operator()() const {return condition_result(test());}
+
+    template <typename Columns>
+    static bool test_at(Columns const& columns, std::size_t i) {
+      return test(std::get<std::span<source_type const>>(columns)[i]);
+    }
+
+  private:
+    source_type const& _source;
+  };
+
+  template <auto member, auto bound>
+  using Less = Comparison<member, std::less<>, bound>;
+  template <auto member, auto bound>
+  using LessEqual = Comparison<member, std::less_equal<>, bound>;
+  template <auto member, auto bound>
+  using Greater = Comparison<member, std::greater<>, bound>;
+  template <auto member, auto bound>
+  using GreaterEqual = Comparison<member, std::greater_equal<>, bound>;
+  template <auto member, auto bound>
+  using Equal = Comparison<member, std::equal_to<>, bound>;
+  template <auto member, auto bound>
+  using NotEqual = Comparison<member, std::not_equal_to<>, bound>;
+
+  template <Condition... Operands>
+  class And {
+  public:
+    static constexpr bool pure = true;
+
+    And(Operands&&... operands) : _operands(std::forward<Operands>(operands)...) {}
+    And(And const&) = default;
+    And(And &&) = default;
+
+    bool test() const {
+      return std::apply([](auto const&... operand) {return (true & ... & operand.test());}, _operands);
+    }
+    Result operator()() const {return condition_result(test());}
+
+    template <typename Columns>
+    static bool test_at(Columns const& columns, std::size_t i) {
+      return (true & ... & Operands::test_at(columns, i));
+    }
+
+  private:
+    std::tuple<Operands...> _operands;
+  };
+
+  template <Condition... Operands>
+  class Or {
+  public:
+    static constexpr bool pure = true;
+
+    Or(Operands&&... operands) : _operands(std::forward<Operands>(operands)...) {}
+    Or(Or const&) = default;
+    Or(Or &&) = default;
+
+    bool test() const {
+      return std::apply([](auto const&... operand) {return (false | ... | operand.test());}, _operands);
+    }
+    Result operator()() const {return condition_result(test());}
+
+    template <typename Columns>
+    static bool test_at(Columns const& columns, std::size_t i) {
+      return (false | ... | Operands::test_at(columns, i));
+    }
+
+  private:
+    std::tuple<Operands...> _operands;
+  };
+
+  template <Condition Operand>
+  class Not {
+  public:
+    static constexpr bool pure = true;
+
+    Not(Operand&& operand) : _operand(std::forward<Operand>(operand)) {}
+    Not(Not const&) = default;
+    Not(Not &&) = default;
+
+    bool test() const {return !_operand.test();}
+    Result operator()() const {return condition_result(test());}
+
+    template <typename Columns>
+    static bool test_at(Columns const& columns, std::size_t i) {return !Operand::test_at(columns, i);}
+
+  private:
+    Operand _operand;
+  };
+
+  // Tests C for out.size() agents, agent i being element i of each column.
+  // Lanes come out Succeeded or Failed, never Running.
+  template <Condition C, typename... Sources>
+  void evaluate(condition::Columns<Sources...> const& columns, ResultLanes& out) {
+    std::uint64_t* succeeded = out.succeeded();
+    std::uint64_t* failed = out.failed();
+    for (std::size_t word = 0; word < out.words(); ++word) {
+      std::size_t first = word * ResultLanes::kLanesPerWord;
+      std::size_t lanes = first >= out.size() ? 0 :
+	std::min(ResultLanes::kLanesPerWord, out.size() - first);
+      // Tests into bytes first, which vectorizes, then packs eight bytes at a
+      // time into bits with a multiply.
+      alignas(8) std::uint8_t tested[ResultLanes::kLanesPerWord] = {};
+      if (lanes == ResultLanes::kLanesPerWord) {
+	for (std::size_t b = 0; b < ResultLanes::kLanesPerWord; ++b) tested[b] = C::test_at(columns, first + b);
+      } else {
+	for (std::size_t b = 0; b < lanes; ++b) tested[b] = C::test_at(columns, first + b);
+      }
+      std::uint64_t bits = 0;
+      for (std::size_t byte = 0; byte < 8; ++byte) {
+	std::uint64_t eight;
+	std::memcpy(&eight, tested + 8 * byte, 8);
+	bits |= ((eight * 0x0102040810204080) >> 56) << (8 * byte);
+      }
+      std::uint64_t valid = lanes == ResultLanes::kLanesPerWord ? ~std::uint64_t{0} :
+	(std::uint64_t{1} << lanes) - 1;
+      succeeded[word] = bits;
+      failed[word] = ~bits & valid;
+    }
+  }
+
+} // namespace tickles
+
+#endif
@@ -0,0 +1,100 @@
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "behavior_tree.h"
+#include "condition.h"
+#include "result_lanes.h"
+
+using tickles::And;
+using tickles::Greater;
+using tickles::Less;
+using tickles::LessEqual;
+using tickles::Not;
+using tickles::Or;
+using tickles::Result;
+using tickles::ResultLanes;
+
+namespace {
+
+  struct Position {
+    int position = 0;
+  };
+
+  struct Charge {
+    double charge = 1;
+  };
+
+  // The tests of BatteryOk and GoAboutBusiness in robot.cc, as a
+  // hand-written leaf and as a condition.
+  struct HandWritten {
+    Position const& position;
+    Charge const& charge;
+    Result operator()() const {
+      if (charge.charge <= 0.2) return Result::Failed;
+      if (position.position < 500) return Result::Succeeded;
+      if (position.position > 1000) return Result::Failed;
+      return Result::Succeeded;
+    }
+  };
+
+  using Dsl = And<Not<LessEqual<&Charge::charge, 0.2>>,
+		  Or<Less<&Position::position, 500>, Not<Greater<&Position::position, 1000>>>>;
+
+  struct Agents {
+    explicit Agents(std::size_t n) : positions(n), charges(n) {
+      std::mt19937 rng(1);
+      std::uniform_int_distribution<int> position(0, 1500);
+      std::uniform_real_distribution<double> charge(0, 1);
+      for (std::size_t i = 0; i < n; ++i) {
+	positions[i].position = position(rng);
+	charges[i].charge = charge(rng);
+      }
+    }
+    std::vector<Position> positions;
+    std::vector<Charge> charges;
+  };
+
+  template <typename Node>
+  Node make(Position const& p, Charge const& c) {
+    if constexpr (std::is_same_v<Node, HandWritten>) return HandWritten{p, c};
+    else return Dsl{Not<LessEqual<&Charge::charge, 0.2>>(LessEqual<&Charge::charge, 0.2>(c)),
+		    Or<Less<&Position::position, 500>, Not<Greater<&Position::position, 1000>>>(
+		      Less<&Position::position, 500>(p),
+		      Not<Greater<&Position::position, 1000>>(Greater<&Position::position, 1000>(p)))};
+  }
+
+}
+
+// One agent ticked at a time, over range(0) agents with random inputs so
+// that the branches of the hand-written leaf are unpredictable.
+template <typename Node>
+static void BM_OneAtATime(benchmark::State& state) {
+  Agents agents(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    int succeeded = 0;
+    for (std::size_t i = 0; i < agents.positions.size(); ++i) {
+      succeeded += make<Node>(agents.positions[i], agents.charges[i])() == Result::Succeeded;
+    }
+    benchmark::DoNotOptimize(succeeded);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OneAtATime<HandWritten>)->Arg(4096);
+BENCHMARK(BM_OneAtATime<Dsl>)->Arg(4096);
+
+// All agents at once into ResultLanes.
+static void BM_Batched(benchmark::State& state) {
+  Agents agents(static_cast<std::size_t>(state.range(0)));
+  tickles::condition::Columns<Position, Charge> columns{agents.positions, agents.charges};
+  ResultLanes out(agents.positions.size());
+  for (auto _ : state) {
+    tickles::evaluate<Dsl>(columns, out);
+    benchmark::DoNotOptimize(out.succeeded());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Batched)->Arg(4096);
+
+BENCHMARK_MAIN();
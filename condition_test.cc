@@ -0,0 +1,119 @@
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "autonomy.h"
+#include "behavior_tree.h"
+#include "blackboard.h"
+#include "condition.h"
+#include "mutable.h"
+#include "reordering_parallel.h"
+#include "result_lanes.h"
+#include "tree_traits.h"
+
+using tickles::And;
+using tickles::Autonomy;
+using tickles::Blackboard;
+using tickles::Condition;
+using tickles::Greater;
+using tickles::Less;
+using tickles::LessEqual;
+using tickles::Mutable;
+using tickles::Mutator;
+using tickles::Not;
+using tickles::Or;
+using tickles::Result;
+using tickles::ResultLanes;
+using tickles::Sequence;
+
+namespace {
+
+  struct Position {
+    int position = 0;
+  };
+
+  struct Charge {
+    double charge = 1;
+  };
+
+  using LowBattery = LessEqual<&Charge::charge, 0.2>;
+  using NearHome = Less<&Position::position, 500>;
+  using FarOut = Greater<&Position::position, 1000>;
+  using ShouldReturn = Or<LowBattery, FarOut>;
+  using Explore = And<NearHome, Not<LowBattery>>;
+
+  static_assert(Condition<ShouldReturn>);
+  static_assert(tickles::PureNode<Explore>);
+  static_assert(tickles::leaf_count_v<Explore> == 1);
+
+  bool explore(Position const& p, Charge const& c) {return p.position < 500 && !(c.charge <= 0.2);}
+  bool should_return(Position const& p, Charge const& c) {return c.charge <= 0.2 || p.position > 1000;}
+
+  struct Speed {
+    int value = 0;
+    bool operator==(Speed const&) const = default;
+  };
+
+  struct Go {
+    Mutator<Speed> speed;
+    Result operator()() const {
+      speed.set(Speed{10});
+      return Result::Running;
+    }
+  };
+
+  struct Data {
+    std::shared_ptr<Blackboard<Position, Charge>> inputs;
+    std::shared_ptr<Mutable<Speed> const> speed;
+  };
+
+  struct Explorer : Autonomy<Data, Sequence<Explore, Go>> {
+    using Autonomy::sync;
+  };
+
+}
+
+TEST(Condition, ComparesMembers) {
+  Position p{400};
+  Charge c{0.5};
+  EXPECT_EQ(NearHome(p)(), Result::Succeeded);
+  EXPECT_EQ(LowBattery(c)(), Result::Failed);
+  Explore explore{NearHome(p), Not<LowBattery>(LowBattery(c))};
+  EXPECT_EQ(explore(), Result::Succeeded);
+  c.charge = 0.2;
+  EXPECT_EQ(explore(), Result::Failed);
+  p.position = 2000;
+  c.charge = 0.9;
+  EXPECT_EQ((ShouldReturn{LowBattery(c), FarOut(p)}()), Result::Succeeded);
+}
+
+TEST(Condition, WiresThroughInjection) {
+  Explorer explorer;
+  explorer.data().inputs->set<Position>(Position{100});
+  explorer.sync();
+  EXPECT_EQ(explorer.data().speed->get().value, 10);
+}
+
+TEST(Condition, BatchedMatchesOneAtATime) {
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<int> position(0, 1500);
+  std::uniform_real_distribution<double> charge(0, 1);
+  for (std::size_t agents : {1, 63, 64, 65, 300}) {
+    std::vector<Position> positions(agents);
+    std::vector<Charge> charges(agents);
+    for (std::size_t i = 0; i < agents; ++i) {
+      positions[i].position = position(rng);
+      charges[i].charge = charge(rng);
+    }
+    tickles::condition::Columns<Position, Charge> columns{positions, charges};
+    ResultLanes explored(agents), returned(agents);
+    tickles::evaluate<Explore>(columns, explored);
+    tickles::evaluate<ShouldReturn>(columns, returned);
+    for (std::size_t i = 0; i < agents; ++i) {
+      EXPECT_EQ(explored.get(i), tickles::condition_result(explore(positions[i], charges[i])));
+      EXPECT_EQ(returned.get(i), tickles::condition_result(should_return(positions[i], charges[i])));
+    }
+    EXPECT_EQ(explored.count(Result::Running), 0);
+  }
+}
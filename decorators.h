@@ -0,0 +1,140 @@
+#ifndef TICKLES_DECORATORS_H
+#define TICKLES_DECORATORS_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <tuple>
+
+#include "behavior_tree.h"
+#include "clock.h"
+#include "input.h"
+
+namespace tickles {
+
+  // Caches the Result of a subtree that is a pure function of Inputs. The
+  // child is only evaluated again once one of the inputs reports a new
+  // version, so a condition reading a committed Mutable is re-run on the
+  // fixpoint iteration after the commit and not on every tick. A hooked
+  // Node is ticked through tick(), and a tick parked inside it is not cached.
+  template<BehaviorTreeNode Node, Versioned... Inputs>
+  class Memoize {
+  public:
+    using child_types = std::tuple<Node>;
+    static constexpr Ticking ticking = ticking_of<Node>;
+
+    Memoize(Node&& node, std::shared_ptr<Inputs>... inputs)
+      : _node(std::forward<Node>(node)), _inputs(std::move(inputs)...) {}
+    Memoize(Memoize const&) = default;
+    Memoize(Memoize &&) = default;
+
+    template <typename F>
+    void for_each_child(F&& f) const {f(_node);}
+
+    Result operator()() const {
+      auto versions = current_versions();
+      if (_cached && versions == _versions) {
+	++_hits;
+	return *_cached;
+      }
+      ++_misses;
+      Result result = tick_child<ticking>(_node);
+      if constexpr (ticking == Ticking::Hooked) {
+	if (tick_suspended()) return result;
+      }
+      _cached = result;
+      _versions = versions;
+      return result;
+    }
+
+    std::uint64_t hits() const {return _hits;}
+    std::uint64_t misses() const {return _misses;}
+
+    // Forces the next call to evaluate the child.
+    void invalidate() {_cached.reset();}
+
+  private:
+    using Versions = std::array<std::uint64_t, sizeof...(Inputs)>;
+
+    Versions current_versions() const {
+      return std::apply([](auto const&... input) {return Versions{input->version()...};},
+			_inputs);
+    }
+
+    Node _node;
+    std::tuple<std::shared_ptr<Inputs>...> _inputs;
+    mutable std::optional<Result> _cached;
+    mutable Versions _versions{};
+    mutable std::uint64_t _hits = 0, _misses = 0;
+  };
+
+  // Runs an expensive child at most once every IntervalMs milliseconds of
+  // ClockT time and answers with the last real Result in between. A new
+  // version on any of RefreshOn forces a run regardless of the interval.
+  // Ticks a hooked Node through tick(), as Memoize does.
+  template<BehaviorTreeNode Node,
+	   std::chrono::milliseconds::rep IntervalMs,
+	   TickClock ClockT = SteadyClock,
+	   Versioned... RefreshOn>
+  class Throttle {
+  public:
+    using child_types = std::tuple<Node>;
+    static constexpr Ticking ticking = ticking_of<Node>;
+    using duration = typename ClockT::duration;
+    using time_point = typename ClockT::time_point;
+
+    Throttle(Node&& node, std::shared_ptr<ClockT> clock, std::shared_ptr<RefreshOn>... refresh_on)
+      : _node(std::forward<Node>(node)), _clock(std::move(clock)), _refresh_on(std::move(refresh_on)...) {}
+    Throttle(Throttle const&) = default;
+    Throttle(Throttle &&) = default;
+
+    template <typename F>
+    void for_each_child(F&& f) const {f(_node);}
+
+    Result operator()() const {
+      auto now = _clock->now();
+      auto versions = current_versions();
+      if (_last && now - _last_run < _min_interval && versions == _versions) {
+	++_skipped;
+	return *_last;
+      }
+      ++_runs;
+      Result result = tick_child<ticking>(_node);
+      if constexpr (ticking == Ticking::Hooked) {
+	if (tick_suspended()) return result;
+      }
+      _last = result;
+      _last_run = now;
+      _versions = versions;
+      return result;
+    }
+
+    duration min_interval() const {return _min_interval;}
+    void min_interval(duration d) {_min_interval = d;}
+
+    std::uint64_t runs() const {return _runs;}
+    std::uint64_t skipped() const {return _skipped;}
+
+  private:
+    using Versions = std::array<std::uint64_t, sizeof...(RefreshOn)>;
+
+    Versions current_versions() const {
+      return std::apply([](auto const&... input) {return Versions{input->version()...};},
+			_refresh_on);
+    }
+
+    Node _node;
+    std::shared_ptr<ClockT> _clock;
+    std::tuple<std::shared_ptr<RefreshOn>...> _refresh_on;
+    duration _min_interval = std::chrono::milliseconds(IntervalMs);
+    mutable std::optional<Result> _last;
+    mutable time_point _last_run{};
+    mutable Versions _versions{};
+    mutable std::uint64_t _runs = 0, _skipped = 0;
+  };
+
+} // namespace tickles
+
+#endif
@@ -0,0 +1,281 @@
+#include <typeinfo>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "decorators.h"
+#include "input.h"
+#include "mutable.h"
+#include "tick_observer.h"
+#include "boost/di.hpp"
+
+namespace di = boost::di;
+
+using tickles::Input;
+using tickles::ManualClock;
+using tickles::Memoize;
+using tickles::Mutable;
+using tickles::MutableRegistry;
+using tickles::Mutator;
+using tickles::OrderedPass;
+using tickles::Result;
+using tickles::Sequence;
+using tickles::Throttle;
+using tickles::Ticking;
+using tickles::TickObserver;
+
+using namespace std::chrono_literals;
+
+namespace {
+
+  struct Level {
+    int level = 0;
+  };
+
+  struct Armed {
+    bool armed = false;
+    bool operator==(Armed const&) const = default;
+  };
+
+}
+
+template <> struct tickles::mutable_hooks<Armed> {static constexpr bool enabled = true;};
+
+namespace {
+
+  struct LevelOk {
+    Input<Level> const& level;
+    std::shared_ptr<int> calls;
+
+    Result operator()() const {
+      ++*calls;
+      return level.get().level >= 10 ? Result::Succeeded : Result::Failed;
+    }
+  };
+
+  // Asks to be ticked through tick(), so that observers see it.
+  struct HookedLevelOk : LevelOk {
+    static constexpr Ticking ticking = Ticking::Hooked;
+  };
+
+  // The nodes ticked while it is installed, outermost first.
+  struct Ticked : TickObserver {
+    std::vector<std::type_info const*> nodes;
+    void begin_node(std::type_info const& node) override {nodes.push_back(&node);}
+  };
+
+  struct IsArmed {
+    Mutator<Armed> armed;
+    std::shared_ptr<int> calls;
+
+    Result operator()() const {
+      ++*calls;
+      return armed.get().armed ? Result::Succeeded : Result::Failed;
+    }
+  };
+
+}
+
+TEST(Memoize, HitsWhileInputsUnchanged) {
+  auto level = std::make_shared<Input<Level>>();
+  auto calls = std::make_shared<int>(0);
+  Memoize<LevelOk, Input<Level>> memo(LevelOk{*level, calls}, level);
+
+  EXPECT_EQ(memo(), Result::Failed);
+  EXPECT_EQ(memo(), Result::Failed);
+  EXPECT_EQ(memo(), Result::Failed);
+  EXPECT_EQ(*calls, 1);
+  EXPECT_EQ(memo.misses(), 1);
+  EXPECT_EQ(memo.hits(), 2);
+}
+
+TEST(Memoize, MissesWhenInputChanges) {
+  auto level = std::make_shared<Input<Level>>();
+  auto calls = std::make_shared<int>(0);
+  Memoize<LevelOk, Input<Level>> memo(LevelOk{*level, calls}, level);
+
+  EXPECT_EQ(memo(), Result::Failed);
+  level->set(Level{20});
+  EXPECT_EQ(memo(), Result::Succeeded);
+  EXPECT_EQ(memo(), Result::Succeeded);
+  EXPECT_EQ(*calls, 2);
+  EXPECT_EQ(memo.misses(), 2);
+  EXPECT_EQ(memo.hits(), 1);
+}
+
+TEST(Memoize, InvalidateForcesEvaluation) {
+  auto level = std::make_shared<Input<Level>>();
+  auto calls = std::make_shared<int>(0);
+  Memoize<LevelOk, Input<Level>> memo(LevelOk{*level, calls}, level);
+
+  memo();
+  memo.invalidate();
+  memo();
+  EXPECT_EQ(*calls, 2);
+}
+
+TEST(Memoize, MutableInputChangesOnlyOnCommit) {
+  auto registry = std::make_shared<MutableRegistry>();
+  auto armed = std::make_shared<Mutable<Armed>>(registry);
+  auto calls = std::make_shared<int>(0);
+  Memoize<IsArmed, Mutable<Armed>> memo(IsArmed{Mutator<Armed>(armed), calls}, armed);
+
+  EXPECT_EQ(memo(), Result::Failed);
+  armed->set(Armed{true});
+  EXPECT_EQ(memo(), Result::Failed);
+  EXPECT_EQ(*calls, 1);
+
+  EXPECT_TRUE(registry->sync());
+  EXPECT_EQ(memo(), Result::Succeeded);
+  EXPECT_EQ(*calls, 2);
+
+  EXPECT_FALSE(registry->sync());
+  EXPECT_EQ(memo(), Result::Succeeded);
+  EXPECT_EQ(*calls, 2);
+}
+
+TEST(Memoize, MutableInputChangesWithinOrderedPass) {
+  auto registry = std::make_shared<MutableRegistry>();
+  auto armed = std::make_shared<Mutable<Armed>>(registry);
+  auto calls = std::make_shared<int>(0);
+  Memoize<IsArmed, Mutable<Armed>> memo(IsArmed{Mutator<Armed>(armed), calls}, armed);
+  OrderedPass pass;
+  OrderedPass::Install ordered(&pass);
+  pass.begin();
+
+  EXPECT_EQ(memo(), Result::Failed);
+  armed->set(Armed{true});
+  EXPECT_EQ(memo(), Result::Succeeded);
+  EXPECT_EQ(*calls, 2);
+
+  // The first read came before the set(), so the commit asks for another
+  // pass, in which the memo already has what it commits.
+  EXPECT_TRUE(registry->sync());
+  pass.begin();
+  EXPECT_EQ(memo(), Result::Succeeded);
+  EXPECT_EQ(*calls, 2);
+
+  armed->set(Armed{false});
+  armed->discard();
+  EXPECT_EQ(memo(), Result::Succeeded);
+  EXPECT_EQ(*calls, 2);
+}
+
+TEST(Memoize, InjectsSharedInputs) {
+  struct Tree : Sequence<Memoize<LevelOk, Input<Level>>> {};
+  auto injector = di::make_injector();
+  auto tree = injector.create<Tree>();
+  auto level = injector.create<std::shared_ptr<Input<Level>>>();
+  auto calls = injector.create<std::shared_ptr<int>>();
+  *calls = 0;
+
+  level->set(Level{5});
+  EXPECT_EQ(tree(), Result::Failed);
+  EXPECT_EQ(tree(), Result::Failed);
+  level->set(Level{15});
+  EXPECT_EQ(tree(), Result::Succeeded);
+  EXPECT_EQ(*calls, 2);
+}
+
+TEST(Throttle, ReturnsLastResultWithinInterval) {
+  auto clock = std::make_shared<ManualClock>();
+  auto level = std::make_shared<Input<Level>>();
+  auto calls = std::make_shared<int>(0);
+  Throttle<LevelOk, 100, ManualClock> throttle(LevelOk{*level, calls}, clock);
+
+  EXPECT_EQ(throttle(), Result::Failed);
+  level->set(Level{20});
+  clock->advance(99ms);
+  EXPECT_EQ(throttle(), Result::Failed);
+  EXPECT_EQ(*calls, 1);
+
+  clock->advance(1ms);
+  EXPECT_EQ(throttle(), Result::Succeeded);
+  EXPECT_EQ(*calls, 2);
+  EXPECT_EQ(throttle.runs(), 2);
+  EXPECT_EQ(throttle.skipped(), 1);
+}
+
+TEST(Throttle, IntervalIsAdjustable) {
+  auto clock = std::make_shared<ManualClock>();
+  auto level = std::make_shared<Input<Level>>();
+  auto calls = std::make_shared<int>(0);
+  Throttle<LevelOk, 100, ManualClock> throttle(LevelOk{*level, calls}, clock);
+  throttle.min_interval(10ms);
+
+  throttle();
+  clock->advance(10ms);
+  throttle();
+  EXPECT_EQ(*calls, 2);
+}
+
+TEST(Throttle, RefreshesWhenNamedInputChanges) {
+  auto clock = std::make_shared<ManualClock>();
+  auto level = std::make_shared<Input<Level>>();
+  auto calls = std::make_shared<int>(0);
+  Throttle<LevelOk, 100, ManualClock, Input<Level>> throttle(LevelOk{*level, calls}, clock, level);
+
+  EXPECT_EQ(throttle(), Result::Failed);
+  EXPECT_EQ(throttle(), Result::Failed);
+  level->set(Level{20});
+  EXPECT_EQ(throttle(), Result::Succeeded);
+  EXPECT_EQ(*calls, 2);
+}
+
+TEST(Throttle, RefreshesWhenMutableChangesWithinOrderedPass) {
+  auto clock = std::make_shared<ManualClock>();
+  auto registry = std::make_shared<MutableRegistry>();
+  auto armed = std::make_shared<Mutable<Armed>>(registry);
+  auto calls = std::make_shared<int>(0);
+  Throttle<IsArmed, 100, ManualClock, Mutable<Armed>> throttle(IsArmed{Mutator<Armed>(armed), calls}, clock, armed);
+  OrderedPass pass;
+  OrderedPass::Install ordered(&pass);
+  pass.begin();
+
+  EXPECT_EQ(throttle(), Result::Failed);
+  armed->set(Armed{true});
+  EXPECT_EQ(throttle(), Result::Succeeded);
+  EXPECT_EQ(*calls, 2);
+}
+
+TEST(Throttle, InjectsClock) {
+  struct Tree : Sequence<Throttle<LevelOk, 50, ManualClock>> {};
+  auto injector = di::make_injector();
+  auto tree = injector.create<Tree>();
+  auto clock = injector.create<std::shared_ptr<ManualClock>>();
+  auto calls = injector.create<std::shared_ptr<int>>();
+  *calls = 0;
+
+  tree();
+  tree();
+  clock->advance(50ms);
+  tree();
+  EXPECT_EQ(*calls, 2);
+}
+
+TEST(Memoize, TicksWrappedNodeThroughTick) {
+  auto level = std::make_shared<Input<Level>>();
+  auto calls = std::make_shared<int>(0);
+  using Memo = Memoize<HookedLevelOk, Input<Level>>;
+  Sequence<Memo> tree(Memo(HookedLevelOk{{*level, calls}}, level));
+  Ticked ticked;
+  TickObserver::Install install(&ticked);
+  tree();
+  tree();
+  // The cache hit ticks the decorator but not what it wraps.
+  ASSERT_EQ(ticked.nodes.size(), 3);
+  EXPECT_EQ(*ticked.nodes[0], typeid(Memo));
+  EXPECT_EQ(*ticked.nodes[1], typeid(HookedLevelOk));
+  EXPECT_EQ(*ticked.nodes[2], typeid(Memo));
+}
+
+TEST(Throttle, TicksWrappedNodeThroughTick) {
+  auto clock = std::make_shared<ManualClock>();
+  auto level = std::make_shared<Input<Level>>();
+  auto calls = std::make_shared<int>(0);
+  Ticked ticked;
+  TickObserver::Install install(&ticked);
+  Throttle<HookedLevelOk, 100, ManualClock> throttle(HookedLevelOk{{*level, calls}}, clock);
+  throttle();
+  ASSERT_EQ(ticked.nodes.size(), 1);
+  EXPECT_EQ(*ticked.nodes[0], typeid(HookedLevelOk));
+}
@@ -0,0 +1,186 @@
+#include "delta.h"
+
+#include <cstring>
+
+namespace tickles {
+
+void put_varint(CheckpointWriter& writer, std::uint64_t value) {
+  std::uint8_t bytes[10];
+  std::size_t n = 0;
+  do {
+    bytes[n] = static_cast<std::uint8_t>(value & 0x7f);
+    value >>= 7;
+    if (value) bytes[n] |= 0x80;
+    ++n;
+  } while (value);
+  writer.write(bytes, n);
+}
+
+bool get_varint(CheckpointReader& reader, std::uint64_t& value) {
+  value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    std::uint8_t byte;
+    if (!reader.read(&byte, 1)) return false;
+    value |= std::uint64_t{byte & 0x7fu} << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+namespace {
+
+  std::size_t varint_size(std::uint64_t value) {
+    std::size_t n = 1;
+    while (value >>= 7) ++n;
+    return n;
+  }
+
+  // Writes mut's value preceded by its length. The length is assumed to fit
+  // one byte and the value moved along if it does not.
+  bool put_value(CheckpointWriter& writer, MutableBase const& mut) {
+    std::size_t at = writer.size();
+    std::uint8_t placeholder = 0;
+    writer.write(&placeholder, 1);
+    if (!mut.save_value(writer) || writer.overflowed()) return false;
+    std::size_t length = writer.size() - at - 1;
+    std::size_t extra = varint_size(length) - 1;
+    if (extra) {
+      std::uint8_t padding[9] = {};
+      writer.write(padding, extra);
+      if (writer.overflowed()) return false;
+      std::byte* data = writer.buffer().data() + at;
+      std::memmove(data + 1 + extra, data + 1, length);
+    }
+    std::byte* data = writer.buffer().data() + at;
+    for (std::size_t i = 0; i <= extra; ++i, length >>= 7) {
+      data[i] = static_cast<std::byte>((length & 0x7f) | (i < extra ? 0x80 : 0));
+    }
+    return true;
+  }
+
+} // namespace
+
+DeltaEncoder::DeltaEncoder(MutableRegistry& registry) : _registry(registry) {
+  _registry.clear_committed();
+  _registry.record_commits(true);
+}
+
+DeltaEncoder::~DeltaEncoder() {
+  _registry.record_commits(false);
+  _registry.clear_committed();
+}
+
+DeltaEncoder::Announced& DeltaEncoder::announced(std::uint32_t index) {
+  if (index >= _announced.size()) _announced.resize(index + 1);
+  return _announced[index];
+}
+
+std::size_t DeltaEncoder::encode(std::span<std::byte> buffer) {
+  std::size_t size = write(buffer, _registry.committed(), false);
+  if (size) _registry.clear_committed();
+  return size;
+}
+
+std::size_t DeltaEncoder::encode_all(std::span<std::byte> buffer) {
+  _all.clear();
+  for (MutableBase const* mut : _registry.mutables()) _all.push_back(*mut->handle());
+  std::size_t size = write(buffer, _all, true);
+  if (size) _registry.clear_committed();
+  return size;
+}
+
+std::size_t DeltaEncoder::write(std::span<std::byte> buffer, std::span<MutableHandle const> handles,
+				bool announce_all) {
+  std::uint64_t sequence = _sequence + 1;
+  // The count goes first but is only known at the end; entries are written
+  // after room for the largest count there can be, then moved up.
+  CheckpointWriter writer(buffer);
+  put_varint(writer, sequence);
+  std::size_t count_at = writer.size();
+  std::size_t count_room = varint_size(handles.size());
+  std::uint8_t padding[10] = {};
+  writer.write(padding, count_room);
+
+  std::uint64_t count = 0;
+  std::vector<std::pair<std::uint32_t, Announced>> undo;
+  for (MutableHandle handle : handles) {
+    MutableBase const* mut = _registry.get(handle);
+    if (!mut) continue;
+    Announced& slot = announced(handle.index);
+    if (slot.encoded_in == sequence) continue;
+    std::size_t entry_at = writer.size();
+    undo.emplace_back(handle.index, slot);
+    bool announce = announce_all || !slot.announced || slot.generation != handle.generation;
+    put_varint(writer, std::uint64_t{handle.index} << 1 | announce);
+    if (announce) {
+      std::uint64_t key = checkpoint_key(mut->value_type());
+      writer.write(&key, sizeof(key));
+    }
+    if (!put_value(writer, *mut)) {
+      if (writer.overflowed()) break;
+      // Not Checkpointable: leave it out.
+      writer.rewind(entry_at);
+      undo.pop_back();
+      continue;
+    }
+    slot = Announced{handle.generation, true, sequence};
+    ++count;
+  }
+  if (writer.overflowed()) {
+    for (auto it = undo.rbegin(); it != undo.rend(); ++it) _announced[it->first] = it->second;
+    return 0;
+  }
+  std::size_t room_used = varint_size(count);
+  std::byte* data = buffer.data();
+  std::size_t end = writer.size();
+  if (room_used < count_room) {
+    std::memmove(data + count_at + room_used, data + count_at + count_room, end - count_at - count_room);
+    end -= count_room - room_used;
+  }
+  CheckpointWriter count_writer(buffer.subspan(count_at, room_used));
+  put_varint(count_writer, count);
+  _sequence = sequence;
+  return end;
+}
+
+bool DeltaDecoder::apply(std::span<std::byte const> delta) {
+  _mirror.update();
+  CheckpointReader reader(delta);
+  std::uint64_t sequence, count;
+  if (!get_varint(reader, sequence) || !get_varint(reader, count)) return false;
+  if (sequence <= _sequence) return false;
+  _missed += sequence - _sequence - 1;
+  _sequence = sequence;
+  for (std::uint64_t i = 0; i < count; ++i) {
+    std::uint64_t tagged, length;
+    if (!get_varint(reader, tagged)) return false;
+    std::uint64_t index = tagged >> 1;
+    if (index >= _remote.size()) {
+      if (!(tagged & 1) || index > ~std::uint32_t{0}) return false;
+      _remote.resize(index + 1);
+    }
+    Remote& remote = _remote[index];
+    if (tagged & 1) {
+      std::uint64_t key;
+      if (!reader.read(&key, sizeof(key))) return false;
+      remote = Remote{true, std::nullopt};
+      for (MutableBase* mut : _mirror.mutables()) {
+	if (checkpoint_key(mut->value_type()) == key) {
+	  remote.local = *mut->handle();
+	  break;
+	}
+      }
+    }
+    if (!remote.announced || !get_varint(reader, length)) return false;
+    auto value = reader.take(length);
+    if (reader.failed()) return false;
+    // Types the mirror does not have are skipped.
+    MutableBase* mut = remote.local ? _mirror.get(*remote.local) : nullptr;
+    if (!mut) continue;
+    CheckpointReader value_reader(value);
+    if (!mut->load_value(value_reader) || !value_reader.done()) return false;
+  }
+  return reader.done();
+}
+
+} // namespace tickles
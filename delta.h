@@ -0,0 +1,100 @@
+#ifndef TICKLES_DELTA_H
+#define TICKLES_DELTA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "checkpoint.h"
+#include "mutable.h"
+
+namespace tickles {
+
+  // LEB128: seven bits per byte, low bits first.
+  void put_varint(CheckpointWriter& writer, std::uint64_t value);
+  bool get_varint(CheckpointReader& reader, std::uint64_t& value);
+
+  // Encodes what a MutableRegistry committed since the last delta, for
+  // mirroring an Autonomy's outputs elsewhere without resending what did not
+  // change.
+  //
+  // A delta is a sequence number, an entry count and one entry per Mutable
+  // committed with a new value (once, however many passes changed it). An
+  // entry is the Mutable's slot index, the length of its value and the value
+  // as checkpoint_traits writes it. The first entry for a slot, and the
+  // first after the slot has been reused, also carries the checkpoint_key of
+  // the value type, which is how the decoder finds its own Mutable for that
+  // index. So a tick costs a few bytes of framing plus a couple of bytes and
+  // the value for each changed Mutable. Mutables of types that are not
+  // Checkpointable are left out.
+  //
+  // Encoders and decoders belong to the tick thread, between syncs.
+  class DeltaEncoder {
+  public:
+    explicit DeltaEncoder(MutableRegistry& registry);
+    DeltaEncoder(DeltaEncoder const&) = delete;
+    DeltaEncoder(DeltaEncoder &&) = delete;
+    ~DeltaEncoder();
+
+    // Writes a delta of everything committed since the last one into
+    // buffer and returns its size. Returns 0, keeping the changes for the
+    // next call, if it does not fit.
+    std::size_t encode(std::span<std::byte> buffer);
+
+    // Like encode(), but with every registered Mutable, announced afresh:
+    // what a mirror that has just joined needs first.
+    std::size_t encode_all(std::span<std::byte> buffer);
+
+    std::uint64_t sequence() const {return _sequence;}
+
+  private:
+    struct Announced {
+      std::uint32_t generation = 0;
+      bool announced = false;
+      // Sequence of the delta this slot last went into.
+      std::uint64_t encoded_in = 0;
+    };
+
+    std::size_t write(std::span<std::byte> buffer, std::span<MutableHandle const> handles, bool announce_all);
+    Announced& announced(std::uint32_t index);
+
+    MutableRegistry& _registry;
+    std::uint64_t _sequence = 0;
+    std::vector<Announced> _announced;
+    std::vector<MutableHandle> _all;
+  };
+
+  // Applies deltas to the Mutables of a mirror registry, one with the same
+  // value types as the encoder's (the same DataT and tree, say).
+  class DeltaDecoder {
+  public:
+    explicit DeltaDecoder(MutableRegistry& mirror) : _mirror(mirror) {}
+    DeltaDecoder(DeltaDecoder const&) = delete;
+    DeltaDecoder(DeltaDecoder &&) = delete;
+
+    // Returns false if the delta is damaged or names a slot that was never
+    // announced; entries before the bad one have been applied.
+    bool apply(std::span<std::byte const> delta);
+
+    std::uint64_t sequence() const {return _sequence;}
+    // Deltas that were skipped between the ones applied.
+    std::uint64_t missed() const {return _missed;}
+
+  private:
+    struct Remote {
+      bool announced = false;
+      std::optional<MutableHandle> local;
+    };
+
+    MutableRegistry& _mirror;
+    std::uint64_t _sequence = 0;
+    std::uint64_t _missed = 0;
+    // The mirror's Mutable for each slot index of the encoder's registry.
+    std::vector<Remote> _remote;
+  };
+
+} // namespace tickles
+
+#endif
@@ -0,0 +1,205 @@
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "autonomy.h"
+#include "behavior_tree.h"
+#include "checkpoint.h"
+#include "delta.h"
+#include "input.h"
+#include "mutable.h"
+
+using tickles::Autonomy;
+using tickles::CheckpointReader;
+using tickles::CheckpointWriter;
+using tickles::DeltaDecoder;
+using tickles::DeltaEncoder;
+using tickles::Input;
+using tickles::Mutable;
+using tickles::MutableRegistry;
+using tickles::Mutator;
+using tickles::Result;
+using tickles::Sequence;
+
+namespace {
+
+  struct Pose {
+    double x = 0, y = 0;
+    bool operator==(Pose const&) const = default;
+  };
+
+  struct Speed {
+    int value = 0;
+    bool operator==(Speed const&) const = default;
+  };
+
+}
+
+template <> struct tickles::checkpoint_traits<Pose> : tickles::trivial_checkpoint<Pose> {};
+template <> struct tickles::checkpoint_traits<Speed> : tickles::trivial_checkpoint<Speed> {};
+
+namespace {
+
+  struct Drive {
+    Input<int> const& target;
+    Mutator<Speed> speed;
+    Mutator<Pose> pose;
+    Result operator()() const {
+      speed.set(Speed{target.get() / 2});
+      pose.set(Pose{static_cast<double>(target.get()), 1});
+      return Result::Running;
+    }
+  };
+
+  struct Data {
+    std::shared_ptr<Input<int>> target;
+    std::shared_ptr<Mutable<Speed> const> speed;
+    std::shared_ptr<Mutable<Pose> const> pose;
+  };
+
+  struct Driver : Autonomy<Data, Sequence<Drive>> {
+    using Autonomy::sync;
+  };
+
+  std::span<std::byte const> first(std::array<std::byte, 256> const& buffer, std::size_t n) {
+    return std::span<std::byte const>(buffer).first(n);
+  }
+
+}
+
+TEST(Delta, VarintsRoundTrip) {
+  std::array<std::byte, 64> buffer;
+  CheckpointWriter writer(buffer);
+  std::vector<std::uint64_t> values{0, 1, 127, 128, 300, 1ull << 35, ~0ull};
+  for (auto value : values) tickles::put_varint(writer, value);
+  EXPECT_EQ(writer.size(), 1 + 1 + 1 + 2 + 2 + 6 + 10);
+  CheckpointReader reader(std::span<std::byte const>(buffer).first(writer.size()));
+  for (auto value : values) {
+    std::uint64_t read;
+    ASSERT_TRUE(tickles::get_varint(reader, read));
+    EXPECT_EQ(read, value);
+  }
+  EXPECT_TRUE(reader.done());
+}
+
+TEST(Delta, MirrorsCommittedValues) {
+  auto source = std::make_shared<MutableRegistry>();
+  auto mirror = std::make_shared<MutableRegistry>();
+  Mutable<int> count(source), mirror_count(mirror);
+  Mutable<Pose> pose(source), mirror_pose(mirror);
+  // Not Checkpointable, so never sent.
+  Mutable<std::string> name(source);
+  source->sync();
+  mirror->sync();
+
+  DeltaEncoder encoder(*source);
+  DeltaDecoder decoder(*mirror);
+  std::array<std::byte, 256> buffer;
+
+  count.set(5);
+  pose.set(Pose{1, 2});
+  name.set(std::string("r2"));
+  source->sync();
+  std::size_t size = encoder.encode(buffer);
+  ASSERT_GT(size, 0);
+  ASSERT_TRUE(decoder.apply(first(buffer, size)));
+  EXPECT_EQ(mirror_count.get(), 5);
+  EXPECT_EQ(mirror_pose.get(), (Pose{1, 2}));
+
+  // Announced already: no keys this time.
+  count.set(6);
+  source->sync();
+  std::size_t smaller = encoder.encode(buffer);
+  EXPECT_EQ(smaller, 1 + 1 + 1 + 1 + sizeof(int));
+  ASSERT_TRUE(decoder.apply(first(buffer, smaller)));
+  EXPECT_EQ(mirror_count.get(), 6);
+
+  // Nothing changed: framing only.
+  source->sync();
+  EXPECT_EQ(encoder.encode(buffer), 2);
+  EXPECT_EQ(decoder.missed(), 0);
+}
+
+TEST(Delta, KeepsChangesThatDidNotFit) {
+  auto source = std::make_shared<MutableRegistry>();
+  auto mirror = std::make_shared<MutableRegistry>();
+  Mutable<Pose> pose(source), mirror_pose(mirror);
+  DeltaEncoder encoder(*source);
+  DeltaDecoder decoder(*mirror);
+  pose.set(Pose{3, 4});
+  source->sync();
+  mirror->sync();
+  std::array<std::byte, 8> small;
+  EXPECT_EQ(encoder.encode(small), 0);
+  std::array<std::byte, 256> buffer;
+  std::size_t size = encoder.encode(buffer);
+  ASSERT_GT(size, 0);
+  ASSERT_TRUE(decoder.apply(first(buffer, size)));
+  EXPECT_EQ(mirror_pose.get(), (Pose{3, 4}));
+}
+
+TEST(Delta, RefusesUnannouncedSlotsAndCountsGaps) {
+  auto source = std::make_shared<MutableRegistry>();
+  auto mirror = std::make_shared<MutableRegistry>();
+  Mutable<int> count(source), mirror_count(mirror);
+  DeltaEncoder encoder(*source);
+  std::array<std::byte, 256> buffer;
+  count.set(1);
+  source->sync();
+  mirror->sync();
+  encoder.encode(buffer);
+  count.set(2);
+  source->sync();
+  std::size_t size = encoder.encode(buffer);
+  DeltaDecoder late(*mirror);
+  EXPECT_FALSE(late.apply(first(buffer, size)));
+
+  DeltaDecoder joined(*mirror);
+  size = encoder.encode_all(buffer);
+  ASSERT_TRUE(joined.apply(first(buffer, size)));
+  EXPECT_EQ(mirror_count.get(), 2);
+  EXPECT_EQ(joined.missed(), 2);
+}
+
+TEST(Delta, BytesScaleWithChanges) {
+  auto source = std::make_shared<MutableRegistry>();
+  std::vector<std::unique_ptr<Mutable<int>>> values;
+  for (int i = 0; i < 100; ++i) values.push_back(std::make_unique<Mutable<int>>(source));
+  source->sync();
+  DeltaEncoder encoder(*source);
+  std::array<std::byte, 4096> buffer;
+  for (auto& value : values) value->set(1);
+  source->sync();
+  encoder.encode(buffer);
+
+  std::vector<std::size_t> sizes;
+  for (int changed : {0, 1, 10, 100}) {
+    for (int i = 0; i < changed; ++i) values[i]->set(changed + 1);
+    source->sync();
+    sizes.push_back(encoder.encode(buffer));
+  }
+  // Index, length and value per change; indices from 64 on take two bytes.
+  EXPECT_EQ(sizes[0], 2);
+  EXPECT_EQ(sizes[1], 2 + 6);
+  EXPECT_EQ(sizes[2], 2 + 60);
+  EXPECT_EQ(sizes[3], 2 + 600 + 36);
+}
+
+TEST(Delta, MirrorsAnAutonomy) {
+  Driver robot, dashboard;
+  DeltaEncoder encoder(robot.mutable_registry());
+  DeltaDecoder decoder(dashboard.mutable_registry());
+  std::array<std::byte, 256> buffer;
+  for (int target : {10, 10, 40, 41}) {
+    robot.data().target->set(target);
+    robot.sync();
+    std::size_t size = encoder.encode(buffer);
+    ASSERT_GT(size, 0);
+    ASSERT_TRUE(decoder.apply(first(buffer, size)));
+    EXPECT_EQ(dashboard.data().speed->get(), robot.data().speed->get());
+    EXPECT_EQ(dashboard.data().pose->get(), robot.data().pose->get());
+  }
+}
@@ -0,0 +1,170 @@
+#include "event_tracer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cinttypes>
+
+#include <unistd.h>
+
+#include "type_name.h"
+
+namespace tickles {
+
+namespace {
+
+  std::atomic<std::uint64_t> next_tracer_id{1};
+
+  void append_escaped(std::string& out, std::string const& text) {
+    for (char c : text) {
+      if (c == '"' || c == '\\') out += '\\';
+      out += c;
+    }
+  }
+
+  char const* category(TraceEvent::Kind kind) {
+    switch (kind) {
+    case TraceEvent::Sync:
+    case TraceEvent::Pass: return "autonomy";
+    case TraceEvent::Node: return "node";
+    case TraceEvent::Commit:
+    case TraceEvent::Committed: return "mutable";
+    }
+    return "";
+  }
+
+  void append_micros(std::string& out, std::uint64_t nanoseconds) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%" PRIu64 ".%03" PRIu64, nanoseconds / 1000, nanoseconds % 1000);
+    out += buffer;
+  }
+
+} // namespace
+
+EventTracer::EventTracer(std::size_t events_per_thread)
+  : _id(next_tracer_id.fetch_add(1, std::memory_order_relaxed)),
+    _capacity(std::bit_ceil(std::max<std::size_t>(events_per_thread, 2))),
+    _epoch(std::chrono::steady_clock::now()) {}
+
+EventTracer::~EventTracer() = default;
+
+EventTracer::Ring& EventTracer::attach_thread() {
+  std::lock_guard lock(_mutex);
+  auto self = std::this_thread::get_id();
+  std::size_t i = 0;
+  while (i < _owners.size() && _owners[i] != self) ++i;
+  if (i == _owners.size()) {
+    _rings.push_back(std::make_unique<Ring>(_capacity, static_cast<std::uint32_t>(i + 1)));
+    _owners.push_back(self);
+  }
+  _local = Local{_id, _rings[i].get()};
+  return *_rings[i];
+}
+
+std::size_t EventTracer::drain(std::vector<TraceEvent>& out) {
+  std::lock_guard lock(_mutex);
+  std::size_t drained = 0;
+  for (auto& ring : _rings) {
+    std::uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    std::uint64_t head = ring->head.load(std::memory_order_acquire);
+    for (std::uint64_t i = tail; i < head; ++i) out.push_back(ring->events[i & (ring->events.size() - 1)]);
+    ring->tail.store(head, std::memory_order_release);
+    drained += head - tail;
+  }
+  return drained;
+}
+
+// Only an estimate while threads are recording.
+std::uint64_t EventTracer::dropped() const {
+  std::lock_guard lock(_mutex);
+  std::uint64_t dropped = 0;
+  for (auto const& ring : _rings) dropped += ring->dropped.load(std::memory_order_relaxed);
+  return dropped;
+}
+
+void EventTracer::append_json(std::string& out, TraceEvent const& event) const {
+  out += "{\"name\":\"";
+  switch (event.kind) {
+  case TraceEvent::Sync: out += "sync"; break;
+  case TraceEvent::Pass: out += "pass"; break;
+  case TraceEvent::Commit: out += "commit"; break;
+  case TraceEvent::Node:
+  case TraceEvent::Committed: append_escaped(out, type_name(*event.type)); break;
+  }
+  out += "\",\"cat\":\"";
+  out += category(event.kind);
+  out += event.kind == TraceEvent::Committed ? "\",\"ph\":\"i\",\"s\":\"t\"" : "\",\"ph\":\"X\"";
+  out += ",\"pid\":";
+  out += std::to_string(::getpid());
+  out += ",\"tid\":";
+  out += std::to_string(event.thread);
+  out += ",\"ts\":";
+  append_micros(out, event.start);
+  if (event.kind != TraceEvent::Committed) {
+    out += ",\"dur\":";
+    append_micros(out, event.duration);
+  }
+  if (event.kind == TraceEvent::Sync) {
+    out += ",\"args\":{\"tree\":\"";
+    append_escaped(out, type_name(*event.type));
+    out += "\"}";
+  } else if (event.kind == TraceEvent::Commit) {
+    out += ",\"args\":{\"committed\":";
+    out += std::to_string(event.count);
+    out += '}';
+  }
+  out += '}';
+}
+
+std::string EventTracer::json() {
+  std::vector<TraceEvent> events;
+  drain(events);
+  std::string out = "{\"traceEvents\":[";
+  for (std::size_t i = 0; i < events.size(); ++i) {
+    if (i) out += ",\n";
+    append_json(out, events[i]);
+  }
+  out += "]}\n";
+  return out;
+}
+
+TraceEventFile::TraceEventFile(EventTracer& tracer, std::string const& path, std::chrono::milliseconds period)
+  : _tracer(tracer), _file(std::fopen(path.c_str(), "w")), _period(period) {
+  if (!_file) return;
+  std::fputs("[\n", _file);
+  _thread = std::thread([this] {
+    std::unique_lock lock(_mutex);
+    while (!_stopping) {
+      _wake.wait_for(lock, _period);
+      flush();
+    }
+  });
+}
+
+TraceEventFile::~TraceEventFile() {
+  if (!_file) return;
+  {
+    std::lock_guard lock(_mutex);
+    _stopping = true;
+  }
+  _wake.notify_one();
+  _thread.join();
+  flush();
+  std::fputs("\n]\n", _file);
+  std::fclose(_file);
+}
+
+void TraceEventFile::flush() {
+  _events.clear();
+  if (_tracer.drain(_events) == 0) return;
+  _text.clear();
+  std::uint64_t written = _written.load(std::memory_order_relaxed);
+  for (TraceEvent const& event : _events) {
+    if (written++) _text += ",\n";
+    _tracer.append_json(_text, event);
+  }
+  std::fwrite(_text.data(), 1, _text.size(), _file);
+  std::fflush(_file);
+  _written.store(written, std::memory_order_relaxed);
+}
+
+} // namespace tickles
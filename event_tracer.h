@@ -0,0 +1,188 @@
+#ifndef TICKLES_EVENT_TRACER_H
+#define TICKLES_EVENT_TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+#include "tick_observer.h"
+
+namespace tickles {
+
+  struct TraceEvent {
+    enum Kind : std::uint8_t {
+      // A whole Autonomy::sync(); type is the tree's root.
+      Sync,
+      // One evaluation of the tree within a sync.
+      Pass,
+      // One tick() of a composite or leaf; type is the node.
+      Node,
+      // A MutableRegistry::sync(); count is the Mutables it committed, and
+      // type is null.
+      Commit,
+      // Instant: a Mutable committed a new value; type is its T.
+      Committed,
+    };
+
+    Kind kind;
+    std::uint32_t thread;
+    std::type_info const* type;
+    std::uint64_t count;
+    // Nanoseconds since the tracer was created.
+    std::uint64_t start;
+    std::uint64_t duration;
+  };
+
+  // Timeline of syncs, passes, node ticks and commits, for export as Chrome
+  // trace-event JSON (chrome://tracing, Perfetto).
+  //
+  // Each thread that records gets a single-producer ring of its own, sized
+  // up front; recording is two clock reads and a store into it, and events
+  // that find the ring full are dropped and counted rather than waited on.
+  // drain() empties the rings from any other thread, which is where all the
+  // formatting happens. A tracer records what the Autonomy instances
+  // observing it (see Autonomy::observe()) do while it is enabled; it may be
+  // shared by many of them, and an Autonomy picks up enable() and disable()
+  // at its next sync().
+  class EventTracer : public TickObserver {
+  public:
+    explicit EventTracer(std::size_t events_per_thread = 1 << 14);
+    ~EventTracer() override;
+
+    void enable() {_enabled.store(true, std::memory_order_relaxed);}
+    void disable() {_enabled.store(false, std::memory_order_relaxed);}
+    bool enabled() const {return _enabled.load(std::memory_order_relaxed);}
+
+    bool active() const override {return enabled();}
+    void begin_sync(std::type_info const& tree, bool resuming) override {open();}
+    void end_sync(std::type_info const& tree) override {close(TraceEvent::Sync, &tree);}
+    void begin_pass(std::type_info const& tree) override {open();}
+    void end_pass(std::type_info const& tree) override {close(TraceEvent::Pass, &tree);}
+    void begin_node(std::type_info const& node) override {open();}
+    void end_node(std::type_info const& node) override {close(TraceEvent::Node, &node);}
+    void begin_commit() override {open();}
+    void committed(MutableBase const& mut, std::type_info const& value, bool again) override {
+      instant(TraceEvent::Committed, value);
+    }
+    void end_commit(std::uint64_t committed, bool again) override {
+      close(TraceEvent::Commit, nullptr, committed);
+    }
+
+    void instant(TraceEvent::Kind kind, std::type_info const& type) {
+      record(TraceEvent{kind, 0, &type, 0, now(), 0});
+    }
+
+    // Moves every event recorded so far onto out, ring by ring.
+    std::size_t drain(std::vector<TraceEvent>& out);
+
+    // Events lost to full rings.
+    std::uint64_t dropped() const;
+
+    // One event as a JSON object, with no separator.
+    void append_json(std::string& out, TraceEvent const& event) const;
+
+    // Drains everything into a complete {"traceEvents": [...]} document.
+    std::string json();
+
+    std::uint64_t now() const {
+      return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - _epoch).count());
+    }
+
+  private:
+    struct Ring {
+      explicit Ring(std::size_t capacity, std::uint32_t thread) : events(capacity), thread(thread) {
+	open.reserve(64);
+      }
+      std::vector<TraceEvent> events;
+      std::uint32_t const thread;
+      // Start times of the spans begun on this thread and not yet ended.
+      std::vector<std::uint64_t> open;
+      alignas(64) std::atomic<std::uint64_t> head = 0;
+      std::atomic<std::uint64_t> dropped = 0;
+      alignas(64) std::atomic<std::uint64_t> tail = 0;
+    };
+    struct Local {
+      std::uint64_t tracer;
+      Ring* ring;
+    };
+
+    Ring& local_ring() {return _local.tracer == _id ? *_local.ring : attach_thread();}
+
+    void open() {local_ring().open.push_back(now());}
+
+    void close(TraceEvent::Kind kind, std::type_info const* type, std::uint64_t count = 0) {
+      Ring& ring = local_ring();
+      std::uint64_t start = ring.open.back();
+      ring.open.pop_back();
+      record(TraceEvent{kind, 0, type, count, start, now() - start});
+    }
+
+    void record(TraceEvent event) {
+      Ring& ring = local_ring();
+      std::uint64_t head = ring.head.load(std::memory_order_relaxed);
+      if (head - ring.tail.load(std::memory_order_acquire) == ring.events.size()) {
+	ring.dropped.fetch_add(1, std::memory_order_relaxed);
+	return;
+      }
+      event.thread = ring.thread;
+      ring.events[head & (ring.events.size() - 1)] = event;
+      ring.head.store(head + 1, std::memory_order_release);
+    }
+
+    Ring& attach_thread();
+
+    std::uint64_t const _id;
+    std::size_t const _capacity;
+    std::chrono::steady_clock::time_point const _epoch;
+    std::atomic<bool> _enabled = false;
+    mutable std::mutex _mutex;
+    std::vector<std::unique_ptr<Ring>> _rings;
+    std::vector<std::thread::id> _owners;
+
+    // Zero-initialized, like every thread_local; no tracer has id 0.
+    static inline thread_local Local _local;
+  };
+
+  // Appends what tracer records to a JSON file in the trace-event array
+  // format, draining it every period on a thread of its own. The closing
+  // bracket is written on destruction, but the viewers also accept a file
+  // cut short.
+  class TraceEventFile {
+  public:
+    TraceEventFile(EventTracer& tracer, std::string const& path,
+		   std::chrono::milliseconds period = std::chrono::milliseconds(100));
+    TraceEventFile(TraceEventFile const&) = delete;
+    TraceEventFile(TraceEventFile &&) = delete;
+    ~TraceEventFile();
+
+    bool is_open() const {return _file != nullptr;}
+    std::uint64_t written() const {return _written.load(std::memory_order_relaxed);}
+
+  private:
+    void flush();
+
+    EventTracer& _tracer;
+    std::FILE* _file;
+    std::chrono::milliseconds const _period;
+    std::vector<TraceEvent> _events;
+    std::string _text;
+    std::atomic<std::uint64_t> _written = 0;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    bool _stopping = false;
+    std::thread _thread;
+  };
+
+} // namespace tickles
+
+#endif
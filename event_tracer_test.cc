@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "autonomy.h"
+#include "behavior_tree.h"
+#include "event_tracer.h"
+#include "input.h"
+#include "mutable.h"
+
+using tickles::Autonomy;
+using tickles::EventTracer;
+using tickles::Input;
+using tickles::Mutable;
+using tickles::Mutator;
+using tickles::HookedSequence;
+using tickles::Result;
+using tickles::Sequence;
+using tickles::TraceEvent;
+using tickles::TraceEventFile;
+
+namespace {
+
+  struct Level {
+    int value = 0;
+    bool operator==(Level const&) const = default;
+  };
+
+  struct CopyIn {
+    Input<int> const& in;
+    Mutator<Level> out;
+    Result operator()() const {
+      out.set(Level{in.get()});
+      return Result::Succeeded;
+    }
+  };
+
+  struct Data {
+    std::shared_ptr<Input<int>> in;
+  };
+
+  using Tree = HookedSequence<CopyIn, tickles::AlwaysSucceeded>;
+
+  struct Copier : Autonomy<Data, Tree> {
+    using Autonomy::sync;
+  };
+
+  std::size_t count(std::vector<TraceEvent> const& events, TraceEvent::Kind kind) {
+    return std::ranges::count_if(events, [&](TraceEvent const& e) {return e.kind == kind;});
+  }
+
+  bool inside(TraceEvent const& inner, TraceEvent const& outer) {
+    return inner.start >= outer.start && inner.start + inner.duration <= outer.start + outer.duration;
+  }
+
+}
+
+TEST(EventTracer, RecordsNothingWhileDisabled) {
+  EventTracer tracer;
+  Copier copier;
+  copier.observe(&tracer);
+  copier.data().in->set(1);
+  copier.sync();
+  std::vector<TraceEvent> events;
+  EXPECT_EQ(tracer.drain(events), 0);
+
+  tracer.enable();
+  copier.sync();
+  EXPECT_GT(tracer.drain(events), 0);
+  tracer.disable();
+  copier.data().in->set(2);
+  copier.sync();
+  events.clear();
+  EXPECT_EQ(tracer.drain(events), 0);
+}
+
+TEST(EventTracer, NestsNodesInPassesInSyncs) {
+  EventTracer tracer;
+  tracer.enable();
+  Copier copier;
+  copier.observe(&tracer);
+  copier.data().in->set(1);
+  copier.sync();
+  std::vector<TraceEvent> events;
+  tracer.drain(events);
+
+  // One pass that commits Level, then one that commits nothing.
+  ASSERT_EQ(count(events, TraceEvent::Sync), 1);
+  EXPECT_EQ(count(events, TraceEvent::Pass), 2);
+  EXPECT_EQ(count(events, TraceEvent::Commit), 2);
+  EXPECT_EQ(count(events, TraceEvent::Committed), 1);
+  // Sequence runs in each pass, and both of its children in each pass too.
+  EXPECT_EQ(count(events, TraceEvent::Node), 4);
+
+  auto sync = *std::ranges::find(events, TraceEvent::Sync, &TraceEvent::kind);
+  EXPECT_EQ(*sync.type, typeid(Tree));
+  for (TraceEvent const& e : events) EXPECT_TRUE(inside(e, sync)) << e.kind;
+  for (TraceEvent const& e : events) {
+    if (e.kind != TraceEvent::Node) continue;
+    EXPECT_TRUE(std::ranges::any_of(events, [&](TraceEvent const& pass) {
+	  return pass.kind == TraceEvent::Pass && inside(e, pass);
+	}));
+  }
+  auto committed = *std::ranges::find(events, TraceEvent::Committed, &TraceEvent::kind);
+  EXPECT_EQ(*committed.type, typeid(Level));
+  std::vector<std::uint64_t> commits;
+  for (TraceEvent const& e : events) if (e.kind == TraceEvent::Commit) commits.push_back(e.count);
+  EXPECT_EQ(commits, (std::vector<std::uint64_t>{1, 0}));
+}
+
+TEST(EventTracer, DropsWhenRingIsFull) {
+  EventTracer tracer(8);
+  for (int i = 0; i < 20; ++i) tracer.instant(TraceEvent::Committed, typeid(int));
+  std::vector<TraceEvent> events;
+  EXPECT_EQ(tracer.drain(events), 8);
+  EXPECT_EQ(tracer.dropped(), 12);
+  tracer.instant(TraceEvent::Committed, typeid(int));
+  EXPECT_EQ(tracer.drain(events), 1);
+}
+
+TEST(EventTracer, DrainsWhileAnotherThreadRecords) {
+  EventTracer tracer(1 << 10);
+  std::atomic<bool> done = false;
+  std::thread producer([&] {
+    for (int i = 0; i < 100'000; ++i) tracer.instant(TraceEvent::Committed, typeid(int));
+    done = true;
+  });
+  std::vector<TraceEvent> events;
+  while (!done) tracer.drain(events);
+  producer.join();
+  tracer.drain(events);
+  EXPECT_EQ(events.size() + tracer.dropped(), 100'000);
+  EXPECT_TRUE(std::ranges::is_sorted(events, {}, &TraceEvent::start));
+}
+
+TEST(EventTracer, WritesChromeTraceJson) {
+  EventTracer tracer;
+  tracer.enable();
+  Copier copier;
+  copier.observe(&tracer);
+  copier.data().in->set(1);
+  copier.sync();
+  std::string json = tracer.json();
+  EXPECT_EQ(json.rfind("{\"traceEvents\":[{\"name\":", 0), 0) << json;
+  EXPECT_NE(json.find("\"name\":\"sync\",\"cat\":\"autonomy\",\"ph\":\"X\""), std::string::npos) << json;
+  EXPECT_NE(json.find("\"args\":{\"committed\":1}"), std::string::npos) << json;
+  EXPECT_NE(json.find("\"name\":\"tickles::AlwaysSucceeded\",\"cat\":\"node\""), std::string::npos) << json;
+  EXPECT_NE(json.find("\"ph\":\"i\",\"s\":\"t\""), std::string::npos) << json;
+  EXPECT_EQ(json.substr(json.size() - 3), "]}\n");
+}
+
+TEST(EventTracer, StreamsToFile) {
+  EventTracer tracer;
+  tracer.enable();
+  std::string path = ::testing::TempDir() + "event_tracer_test.json";
+  std::uint64_t written;
+  {
+    TraceEventFile file(tracer, path, std::chrono::milliseconds(1));
+    ASSERT_TRUE(file.is_open());
+    Copier copier;
+    copier.observe(&tracer);
+    // Ten events per sync: sync, two passes of two nodes under a Sequence,
+    // two commits, one of which commits Level.
+    for (int i = 1; i <= 10; ++i) {
+      copier.data().in->set(i);
+      copier.sync();
+    }
+    auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (file.written() < 100 && std::chrono::steady_clock::now() < give_up) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    written = file.written();
+  }
+  EXPECT_EQ(written, 100);
+  std::ifstream in(path);
+  std::stringstream text;
+  text << in.rdbuf();
+  std::string json = text.str();
+  EXPECT_EQ(json.rfind("[\n{\"name\":", 0), 0);
+  EXPECT_EQ(json.substr(json.size() - 4), "}\n]\n");
+  EXPECT_EQ(std::ranges::count(json, '\n'), 100 + 2);
+  std::remove(path.c_str());
+}
@@ -0,0 +1,183 @@
+#include "fixpoint_trace.h"
+
+#include <algorithm>
+#include <functional>
+#include <sstream>
+#include <utility>
+
+#include "type_name.h"
+
+namespace tickles {
+
+std::string DirtyCommit::value_name() const {
+  return value ? type_name(*value) : "<unknown>";
+}
+
+std::string DirtyCommit::writer_name() const {
+  if (writer) return type_name(*writer);
+  return hooked ? "<outside tick>" : "<unhooked>";
+}
+
+FixpointTrace::FixpointTrace(std::size_t capacity) : _ring(capacity) {}
+
+std::uint64_t FixpointTrace::key_of(MutableBase const& mut) {
+  MutableHandle handle = *mut.handle();
+  return std::uint64_t{handle.generation} << 32 | handle.index;
+}
+
+void FixpointTrace::begin_sync(std::type_info const& tree, bool resuming) {
+  if (resuming) return;
+  ++_syncs;
+  _pass = 0;
+}
+
+namespace {
+  void note(std::vector<std::type_info const*>& nodes, std::type_info const* node) {
+    if (!node) return;
+    if (std::ranges::none_of(nodes, [&](std::type_info const* n) {return *n == *node;})) nodes.push_back(node);
+  }
+}
+
+void FixpointTrace::wrote(MutableBase const& mut) {
+  Access& access = _access[key_of(mut)];
+  access.writer = _nodes.empty() ? nullptr : _nodes.back();
+  note(access.writers, access.writer);
+}
+
+void FixpointTrace::read(MutableBase const& mut) {
+  Access& access = _access[key_of(mut)];
+  access.reader = _nodes.empty() ? nullptr : _nodes.back();
+  note(access.readers, access.reader);
+}
+
+void FixpointTrace::committed(MutableBase const& mut, std::type_info const& value, bool again) {
+  std::type_info const* writer = nullptr;
+  std::type_info const* reader = nullptr;
+  std::uint64_t key = key_of(mut);
+  if (auto found = _access.find(key); found != _access.end()) {
+    writer = std::exchange(found->second.writer, nullptr);
+    reader = std::exchange(found->second.reader, nullptr);
+  }
+  if (!again) return;
+  if (!_ring.empty()) _ring[_recorded % _ring.size()] = DirtyCommit{_syncs, _pass, &mut, *mut.handle(), &value, writer, reader, mut.hooked()};
+  ++_recorded;
+  ++_by_mutable.try_emplace(key, Count{&value, 0}).first->second.count;
+  if (writer) ++_by_writer.try_emplace(std::type_index(*writer), Count{writer, 0}).first->second.count;
+  else if (mut.hooked()) ++_outside_tick;
+}
+
+void FixpointTrace::end_commit(std::uint64_t committed, bool again) {
+  ++_pass;
+  if (again) ++_extra_passes;
+  _max_passes = std::max(_max_passes, _pass);
+}
+
+std::vector<std::vector<std::type_info const*>> FixpointTrace::cycles() const {
+  std::vector<std::type_info const*> nodes;
+  std::unordered_map<std::type_index, std::size_t> ids;
+  auto id = [&](std::type_info const* node) {
+    auto [at, added] = ids.try_emplace(std::type_index(*node), nodes.size());
+    if (added) nodes.push_back(node);
+    return at->second;
+  };
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+  for (auto const& [mut, access] : _access) {
+    for (std::type_info const* writer : access.writers) {
+      for (std::type_info const* reader : access.readers) pairs.emplace_back(id(writer), id(reader));
+    }
+  }
+  std::vector<std::vector<std::size_t>> edges(nodes.size());
+  for (auto [from, to] : pairs) edges[from].push_back(to);
+
+  // Tarjan's algorithm.
+  constexpr std::size_t kUnvisited = ~std::size_t{0};
+  std::vector<std::size_t> index(nodes.size(), kUnvisited), low(nodes.size());
+  std::vector<bool> on_stack(nodes.size());
+  std::vector<std::size_t> stack;
+  std::size_t next = 0;
+  std::vector<std::vector<std::type_info const*>> cycles;
+  std::function<void(std::size_t)> visit = [&](std::size_t v) {
+    index[v] = low[v] = next++;
+    stack.push_back(v);
+    on_stack[v] = true;
+    for (std::size_t w : edges[v]) {
+      if (index[w] == kUnvisited) {
+	visit(w);
+	low[v] = std::min(low[v], low[w]);
+      } else if (on_stack[w]) {
+	low[v] = std::min(low[v], index[w]);
+      }
+    }
+    if (low[v] != index[v]) return;
+    std::vector<std::type_info const*> component;
+    std::size_t w;
+    do {
+      w = stack.back();
+      stack.pop_back();
+      on_stack[w] = false;
+      component.push_back(nodes[w]);
+    } while (w != v);
+    if (component.size() > 1 || std::ranges::find(edges[v], v) != edges[v].end()) cycles.push_back(std::move(component));
+  };
+  for (std::size_t v = 0; v < nodes.size(); ++v) if (index[v] == kUnvisited) visit(v);
+  return cycles;
+}
+
+std::vector<DirtyCommit> FixpointTrace::recent() const {
+  std::vector<DirtyCommit> commits;
+  std::uint64_t kept = std::min<std::uint64_t>(_recorded, _ring.size());
+  commits.reserve(kept);
+  for (std::uint64_t i = _recorded - kept; i < _recorded; ++i) commits.push_back(_ring[i % _ring.size()]);
+  return commits;
+}
+
+std::uint64_t FixpointTrace::commits_of(MutableBase const& mut) const {
+  auto found = _by_mutable.find(key_of(mut));
+  return found == _by_mutable.end() ? 0 : found->second.count;
+}
+
+std::uint64_t FixpointTrace::commits_by(std::type_info const& writer) const {
+  auto found = _by_writer.find(std::type_index(writer));
+  return found == _by_writer.end() ? 0 : found->second.count;
+}
+
+std::string FixpointTrace::report() const {
+  auto by_count = [](auto const& counts) {
+    std::vector<std::pair<std::uint64_t, std::string>> sorted;
+    for (auto const& [key, count] : counts) sorted.emplace_back(count.count, type_name(*count.type));
+    std::ranges::sort(sorted, std::greater<>());
+    return sorted;
+  };
+
+  std::ostringstream out;
+  out << _syncs << " syncs, " << _extra_passes << " extra passes, at most "
+      << _max_passes << " passes in one sync\n";
+  out << "writers:\n";
+  for (auto const& [count, name] : by_count(_by_writer)) out << "  " << count << " " << name << "\n";
+  if (_outside_tick) out << "  " << _outside_tick << " <outside tick>\n";
+  out << "mutables:\n";
+  for (auto const& [count, name] : by_count(_by_mutable)) out << "  " << count << " Mutable<" << name << ">\n";
+  auto found = cycles();
+  if (!found.empty()) {
+    out << "cycles:\n";
+    for (auto const& cycle : found) {
+      std::vector<std::string> names;
+      for (std::type_info const* node : cycle) names.push_back(type_name(*node));
+      std::ranges::sort(names);
+      out << " ";
+      for (std::string const& name : names) out << " " << name;
+      out << "\n";
+    }
+  }
+  return out.str();
+}
+
+void FixpointTrace::reset() {
+  _recorded = _syncs = _extra_passes = _outside_tick = 0;
+  _pass = _max_passes = 0;
+  _by_mutable.clear();
+  _by_writer.clear();
+  _access.clear();
+}
+
+} // namespace tickles
@@ -0,0 +1,132 @@
+#ifndef TICKLES_FIXPOINT_TRACE_H
+#define TICKLES_FIXPOINT_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#include "mutable.h"
+#include "tick_observer.h"
+
+namespace tickles {
+
+  // A Mutable that was committed as changed at the end of a pass of sync(),
+  // which is what makes sync() tick the tree again.
+  struct DirtyCommit {
+    // Counts the syncs seen by the trace, from 1.
+    std::uint64_t sync;
+    // Pass of that sync whose writes were committed, from 0.
+    std::uint32_t pass;
+    // May have been destroyed since the commit; handle tells it apart from
+    // any later Mutable at the same address.
+    MutableBase const* mut;
+    MutableHandle handle;
+    // The T of the Mutable<T>.
+    std::type_info const* value;
+    // Innermost node being ticked at the last set() before the commit, or
+    // null if the set() happened outside any tick() or T does not take
+    // mutable_hooks.
+    std::type_info const* writer;
+    // In an ordered pass, the node that had read the value before it
+    // changed, which is what made it stale; null otherwise.
+    std::type_info const* reader = nullptr;
+    // Whether T takes mutable_hooks, without which writers go unseen.
+    bool hooked = true;
+
+    std::string value_name() const;
+    std::string writer_name() const;
+  };
+
+  // Records why sync() needed more than one pass.
+  //
+  // Observing an Autonomy (see Autonomy::observe()), the trace follows which
+  // node is being ticked, takes it as the writer of whatever it set()s, and
+  // hears of every dirty commit. Only the nodes hooked composites tick (see
+  // Ticking) are followed, and only Mutables of types that take
+  // mutable_hooks report their writers; the commits of the others are
+  // counted per Mutable but not by writer. The last capacity commits are kept in a
+  // ring buffer allocated up front; counts per Mutable and per writer are
+  // kept for as long as the trace lives.
+  //
+  // Mutables are told apart by their MutableHandle rather than their address,
+  // which a later Mutable may reuse; handles are only unique within one
+  // MutableRegistry, so a trace should observe a single Autonomy.
+  //
+  // In ordered passes (see OrderedPass) only stale commits are recorded, and
+  // the trace also learns which nodes read and write each Mutable, from
+  // which cycles() finds the nodes that still need more than one pass.
+  // Reads are only reported in ordered passes, so under a plain sync()
+  // cycles() stays empty.
+  class FixpointTrace : public TickObserver {
+  public:
+    explicit FixpointTrace(std::size_t capacity = 1024);
+
+    void begin_sync(std::type_info const& tree, bool resuming) override;
+    void begin_node(std::type_info const& node) override {_nodes.push_back(&node);}
+    void end_node(std::type_info const& node) override {_nodes.pop_back();}
+    void wrote(MutableBase const& mut) override;
+    void read(MutableBase const& mut) override;
+    void committed(MutableBase const& mut, std::type_info const& value, bool again) override;
+    void end_commit(std::uint64_t committed, bool again) override;
+
+    std::uint64_t syncs() const {return _syncs;}
+    // Passes beyond the first, over all syncs.
+    std::uint64_t extra_passes() const {return _extra_passes;}
+    std::uint32_t max_passes() const {return _max_passes;}
+
+    // The most recent dirty commits, oldest first.
+    std::vector<DirtyCommit> recent() const;
+
+    std::uint64_t commits_of(MutableBase const& mut) const;
+    std::uint64_t commits_by(std::type_info const& writer) const;
+    std::uint64_t commits_outside_tick() const {return _outside_tick;}
+
+    // The strongly connected components of the graph with an edge from each
+    // node to every node that reads a Mutable it writes, leaving out those
+    // of a single node that does not read what it writes itself. Every other
+    // node comes after all its writers in some topological order. An
+    // ordered sync() ticks leaves in the tree's own order, not in that one,
+    // so a leaf ticked before its writer costs extra passes too; writing the
+    // tree in topological order saves those, but not the ones these cost.
+    std::vector<std::vector<std::type_info const*>> cycles() const;
+
+    // Writers and Mutables that forced extra passes, most frequent first.
+    std::string report() const;
+
+    void reset();
+
+  private:
+    std::vector<DirtyCommit> _ring;
+    std::uint64_t _recorded = 0;
+    std::uint64_t _syncs = 0;
+    std::uint32_t _pass = 0;
+    std::uint64_t _extra_passes = 0;
+    std::uint32_t _max_passes = 0;
+    std::uint64_t _outside_tick = 0;
+    struct Count {
+      std::type_info const* type;
+      std::uint64_t count;
+    };
+    // Keyed by handle, as by key_of().
+    static std::uint64_t key_of(MutableBase const& mut);
+    std::unordered_map<std::uint64_t, Count> _by_mutable;
+    std::unordered_map<std::type_index, Count> _by_writer;
+    struct Access {
+      std::vector<std::type_info const*> readers;
+      std::vector<std::type_info const*> writers;
+      // Since the last commit.
+      std::type_info const* writer = nullptr;
+      std::type_info const* reader = nullptr;
+    };
+    std::unordered_map<std::uint64_t, Access> _access;
+    // The nodes being ticked, innermost last.
+    std::vector<std::type_info const*> _nodes;
+  };
+
+} // namespace tickles
+
+#endif
@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <tuple>
+
+#include "gtest/gtest.h"
+#include "autonomy.h"
+#include "behavior_tree.h"
+#include "decorators.h"
+#include "fixpoint_trace.h"
+#include "input.h"
+#include "mutable.h"
+#include "tree_traits.h"
+
+using tickles::Autonomy;
+using tickles::FixpointTrace;
+using tickles::HookedSequence;
+using tickles::Input;
+using tickles::Memoize;
+using tickles::Mutable;
+using tickles::MutableBase;
+using tickles::MutableRegistry;
+using tickles::Mutator;
+using tickles::OrderedPass;
+using tickles::Result;
+using tickles::Sequence;
+using tickles::single_pass;
+using tickles::TickObserver;
+
+namespace {
+
+  struct Goal {
+    int value = 0;
+    bool operator==(Goal const&) const = default;
+  };
+
+  struct Echo {
+    int value = 0;
+    bool operator==(Echo const&) const = default;
+  };
+
+}
+
+template <> struct tickles::mutable_hooks<Goal> {static constexpr bool enabled = true;};
+template <> struct tickles::mutable_hooks<Echo> {static constexpr bool enabled = true;};
+
+namespace {
+
+  // Reads what SetGoal wrote in the previous pass, so every new goal takes
+  // two extra passes to settle.
+  struct EchoGoal {
+    using reads = std::tuple<Goal>;
+    using writes = std::tuple<Echo>;
+    Mutator<Goal> goal;
+    Mutator<Echo> echo;
+    Result operator()() const {
+      echo.set(Echo{goal.get().value});
+      return Result::Succeeded;
+    }
+  };
+
+  struct SetGoal {
+    using writes = std::tuple<Goal>;
+    Input<int> const& request;
+    Mutator<Goal> goal;
+    Result operator()() const {
+      goal.set(Goal{request.get()});
+      return Result::Succeeded;
+    }
+  };
+
+  struct Tree : HookedSequence<EchoGoal, SetGoal> {};
+
+  struct Data {
+    std::shared_ptr<Input<int>> request;
+    std::shared_ptr<const Mutable<Goal>> goal;
+    std::shared_ptr<const Mutable<Echo>> echo;
+  };
+
+  template <typename TreeT>
+  struct BasicTestAutonomy : Autonomy<Data, TreeT> {
+    void request(int value) {
+      this->data().request->set(value);
+      this->sync();
+    }
+  };
+
+  using TestAutonomy = BasicTestAutonomy<Tree>;
+
+  struct InOrderTree : HookedSequence<SetGoal, EchoGoal> {};
+
+  static_assert(!single_pass<Tree>);
+  static_assert(single_pass<InOrderTree>);
+
+  struct Ping {
+    int value = 0;
+    bool operator==(Ping const&) const = default;
+  };
+
+  struct Pong {
+    int value = 0;
+    bool operator==(Pong const&) const = default;
+  };
+
+}
+
+template <> struct tickles::mutable_hooks<Ping> {static constexpr bool enabled = true;};
+template <> struct tickles::mutable_hooks<Pong> {static constexpr bool enabled = true;};
+
+namespace {
+
+  // Each one follows the other, up to the request.
+  struct SetPing {
+    Input<int> const& request;
+    Mutator<Ping> ping;
+    Mutator<Pong> pong;
+    Result operator()() const {
+      ping.set(Ping{std::min(pong.get().value + 1, request.get())});
+      return Result::Succeeded;
+    }
+  };
+
+  struct SetPong {
+    Mutator<Ping> ping;
+    Mutator<Pong> pong;
+    Result operator()() const {
+      pong.set(Pong{ping.get().value});
+      return Result::Succeeded;
+    }
+  };
+
+  struct CyclicTree : HookedSequence<SetGoal, SetPing, SetPong> {};
+
+  using MemoEcho = Memoize<EchoGoal, Mutable<Goal>>;
+  struct MemoizedTree : HookedSequence<SetGoal, MemoEcho> {};
+  struct MemoizedFirstTree : HookedSequence<MemoEcho, SetGoal> {};
+
+  // Does not take mutable_hooks, so whoever writes it goes unseen.
+  struct Copy {
+    int value = 0;
+    bool operator==(Copy const&) const = default;
+  };
+
+  struct CopyRequest {
+    Input<int> const& request;
+    Mutator<Copy> copy;
+    Result operator()() const {
+      copy.set(Copy{request.get()});
+      return Result::Succeeded;
+    }
+  };
+
+  struct CopyData {
+    std::shared_ptr<Input<int>> request;
+    std::shared_ptr<const Mutable<Copy>> copy;
+  };
+
+  struct CopyAutonomy : Autonomy<CopyData, HookedSequence<CopyRequest>> {
+    using Autonomy::sync;
+  };
+
+}
+
+TEST(FixpointTrace, AttributesExtraPassesToWriters) {
+  FixpointTrace trace;
+  TestAutonomy autonomy;
+  autonomy.observe(&trace);
+  autonomy.request(7);
+
+  EXPECT_EQ(trace.syncs(), 1);
+  EXPECT_EQ(trace.extra_passes(), 2);
+  EXPECT_EQ(trace.max_passes(), 3);
+  EXPECT_EQ(trace.commits_by(typeid(SetGoal)), 1);
+  EXPECT_EQ(trace.commits_by(typeid(EchoGoal)), 1);
+  EXPECT_EQ(trace.commits_of(*autonomy.data().goal), 1);
+  EXPECT_EQ(trace.commits_of(*autonomy.data().echo), 1);
+
+  auto recent = trace.recent();
+  ASSERT_EQ(recent.size(), 2);
+  EXPECT_EQ(recent[0].pass, 0);
+  EXPECT_EQ(*recent[0].value, typeid(Goal));
+  EXPECT_EQ(*recent[0].writer, typeid(SetGoal));
+  EXPECT_EQ(recent[1].pass, 1);
+  EXPECT_EQ(recent[1].writer_name(), "(anonymous namespace)::EchoGoal");
+}
+
+TEST(FixpointTrace, CountsUnhookedCommitsWithoutWriters) {
+  FixpointTrace trace;
+  CopyAutonomy autonomy;
+  autonomy.observe(&trace);
+  autonomy.data().request->set(3);
+  autonomy.sync();
+
+  EXPECT_EQ(trace.extra_passes(), 1);
+  EXPECT_EQ(trace.commits_of(*autonomy.data().copy), 1);
+  EXPECT_EQ(trace.commits_by(typeid(CopyRequest)), 0);
+  EXPECT_EQ(trace.commits_outside_tick(), 0);
+  ASSERT_EQ(trace.recent().size(), 1);
+  EXPECT_EQ(trace.recent()[0].writer_name(), "<unhooked>");
+}
+
+TEST(FixpointTrace, TellsApartMutablesAtTheSameAddress) {
+  auto registry = std::make_shared<MutableRegistry>();
+  FixpointTrace trace;
+  TickObserver::Install install(&trace);
+  std::optional<Mutable<Goal>> goal;
+  goal.emplace(registry);
+  goal->set(Goal{1});
+  registry->sync();
+  ASSERT_EQ(trace.commits_of(*goal), 1);
+  MutableBase const* first = &*goal;
+
+  goal.reset();
+  registry->sync();
+  goal.emplace(registry);
+  ASSERT_EQ(&*goal, first);
+  EXPECT_EQ(trace.commits_of(*goal), 0);
+  goal->set(Goal{2});
+  registry->sync();
+  EXPECT_EQ(trace.commits_of(*goal), 1);
+  auto recent = trace.recent();
+  ASSERT_EQ(recent.size(), 2);
+  EXPECT_EQ(recent[0].handle.index, recent[1].handle.index);
+  EXPECT_NE(recent[0].handle.generation, recent[1].handle.generation);
+}
+
+TEST(FixpointTrace, QuietSyncsAddNothing) {
+  FixpointTrace trace;
+  TestAutonomy autonomy;
+  autonomy.observe(&trace);
+  autonomy.request(0);
+  autonomy.request(0);
+  EXPECT_EQ(trace.syncs(), 2);
+  EXPECT_EQ(trace.extra_passes(), 0);
+  EXPECT_TRUE(trace.recent().empty());
+}
+
+TEST(FixpointTrace, RingKeepsTheMostRecent) {
+  FixpointTrace trace(3);
+  TestAutonomy autonomy;
+  autonomy.observe(&trace);
+  for (int i = 1; i <= 4; ++i) autonomy.request(i);
+  auto recent = trace.recent();
+  ASSERT_EQ(recent.size(), 3);
+  EXPECT_EQ(recent[0].sync, 3);
+  EXPECT_EQ(recent[2].sync, 4);
+  EXPECT_EQ(trace.commits_by(typeid(SetGoal)), 4);
+}
+
+TEST(FixpointTrace, ReportListsWriters) {
+  FixpointTrace trace;
+  TestAutonomy autonomy;
+  autonomy.observe(&trace);
+  autonomy.request(1);
+  std::string report = trace.report();
+  EXPECT_NE(report.find("1 syncs, 2 extra passes"), std::string::npos) << report;
+  EXPECT_NE(report.find("SetGoal"), std::string::npos) << report;
+  EXPECT_NE(report.find("Mutable<(anonymous namespace)::Echo>"), std::string::npos) << report;
+}
+
+TEST(FixpointTrace, InstalledOnlyDuringSync) {
+  FixpointTrace trace;
+  TestAutonomy autonomy;
+  autonomy.observe(&trace);
+  autonomy.request(1);
+  EXPECT_EQ(TickObserver::current(), nullptr);
+  autonomy.observe(nullptr);
+  autonomy.request(2);
+  EXPECT_EQ(trace.syncs(), 1);
+}
+
+TEST(FixpointTrace, OrderedSyncSettlesInOnePass) {
+  FixpointTrace plain_trace, ordered_trace;
+  BasicTestAutonomy<InOrderTree> plain, ordered;
+  ordered.evaluate_in_order();
+  plain.observe(&plain_trace);
+  ordered.observe(&ordered_trace);
+  plain.request(7);
+  ordered.request(7);
+
+  EXPECT_EQ(plain_trace.max_passes(), 3);
+  EXPECT_EQ(ordered_trace.max_passes(), 1);
+  EXPECT_EQ(ordered_trace.extra_passes(), 0);
+  EXPECT_TRUE(ordered_trace.recent().empty());
+  EXPECT_TRUE(ordered_trace.cycles().empty());
+  EXPECT_EQ(ordered.data().goal->get(), plain.data().goal->get());
+  EXPECT_EQ(ordered.data().echo->get(), Echo{7});
+  EXPECT_EQ(ordered.data().echo->version(), 1);
+  EXPECT_EQ(OrderedPass::current(), nullptr);
+}
+
+TEST(FixpointTrace, OrderedSyncMissesMemoOnUncommittedChange) {
+  FixpointTrace trace;
+  BasicTestAutonomy<MemoizedTree> plain, ordered;
+  ordered.evaluate_in_order();
+  ordered.observe(&trace);
+  plain.request(0);
+  ordered.request(0);
+  plain.request(5);
+  ordered.request(5);
+
+  EXPECT_EQ(plain.data().echo->get(), Echo{5});
+  EXPECT_EQ(ordered.data().echo->get(), Echo{5});
+  EXPECT_EQ(trace.max_passes(), 1);
+}
+
+TEST(FixpointTrace, OrderedSyncRepeatsForMemoHits) {
+  FixpointTrace trace;
+  BasicTestAutonomy<MemoizedFirstTree> autonomy;
+  autonomy.evaluate_in_order();
+  autonomy.observe(&trace);
+  autonomy.request(0);
+  autonomy.request(5);
+
+  // The memo hit in the first pass still read the Goal SetGoal changed.
+  EXPECT_EQ(trace.max_passes(), 2);
+  EXPECT_EQ(autonomy.data().echo->get(), Echo{5});
+}
+
+TEST(FixpointTrace, OrderedSyncRepeatsForStaleReads) {
+  FixpointTrace trace;
+  TestAutonomy autonomy;
+  autonomy.evaluate_in_order();
+  autonomy.observe(&trace);
+  autonomy.request(7);
+
+  // EchoGoal read the Goal before SetGoal changed it, and needs one more
+  // pass to see it; nothing reads the Echo, so that is all.
+  EXPECT_EQ(trace.max_passes(), 2);
+  auto recent = trace.recent();
+  ASSERT_EQ(recent.size(), 1);
+  EXPECT_EQ(*recent[0].value, typeid(Goal));
+  EXPECT_EQ(*recent[0].writer, typeid(SetGoal));
+  EXPECT_EQ(*recent[0].reader, typeid(EchoGoal));
+  EXPECT_EQ(autonomy.data().echo->get(), Echo{7});
+}
+
+TEST(FixpointTrace, CyclesNameNodesThatFeedEachOther) {
+  FixpointTrace trace;
+  BasicTestAutonomy<CyclicTree> autonomy;
+  autonomy.evaluate_in_order();
+  autonomy.observe(&trace);
+  autonomy.request(3);
+
+  // Ping and Pong each go up by one per pass, and the last pass sees no
+  // change.
+  EXPECT_EQ(trace.max_passes(), 4);
+  auto cycles = trace.cycles();
+  ASSERT_EQ(cycles.size(), 1);
+  ASSERT_EQ(cycles[0].size(), 2);
+  EXPECT_TRUE((*cycles[0][0] == typeid(SetPing) && *cycles[0][1] == typeid(SetPong)) ||
+	      (*cycles[0][0] == typeid(SetPong) && *cycles[0][1] == typeid(SetPing)));
+  EXPECT_NE(trace.report().find("cycles:\n  (anonymous namespace)::SetPing (anonymous namespace)::SetPong"),
+	    std::string::npos) << trace.report();
+}
@@ -0,0 +1,103 @@
+#include "fleet.h"
+
+#include <algorithm>
+
+namespace tickles {
+
+namespace {
+
+std::uint64_t nanos_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+FleetExecutor::FleetExecutor(std::size_t workers)
+  : _start(static_cast<std::ptrdiff_t>(std::max<std::size_t>(workers, 1) + 1)),
+    _done(static_cast<std::ptrdiff_t>(std::max<std::size_t>(workers, 1) + 1)) {
+  workers = std::max<std::size_t>(workers, 1);
+  for (std::size_t i = 0; i < workers; ++i) _workers.push_back(std::make_unique<Worker>());
+  for (std::size_t i = 0; i < workers; ++i) {
+    _workers[i]->thread = std::thread([this, i] {work(i);});
+  }
+}
+
+FleetExecutor::~FleetExecutor() {
+  _stopping = true;
+  _start.arrive_and_wait();
+  for (auto& worker : _workers) worker->thread.join();
+}
+
+std::size_t FleetExecutor::add(int priority) {
+  std::size_t task = _priorities.size();
+  _priorities.push_back(priority);
+  auto& home = *std::ranges::min_element(_workers, {}, [](auto const& w) {return w->queue.size();});
+  auto at = std::ranges::upper_bound(home->queue, priority, std::greater<>{},
+				     [this](std::size_t t) {return _priorities[t];});
+  home->queue.insert(at, task);
+  return task;
+}
+
+void FleetExecutor::run(std::function<void(std::size_t)> task) {
+  _task = std::move(task);
+  for (auto& worker : _workers) worker->next.store(0, std::memory_order_relaxed);
+  auto start = std::chrono::steady_clock::now();
+  _start.arrive_and_wait();
+  _done.arrive_and_wait();
+  auto took = nanos_since(start);
+  _tick_latency.record(took);
+  _busy += std::chrono::nanoseconds(took);
+  ++_ticks;
+}
+
+void FleetExecutor::work(std::size_t self) {
+  Worker& me = *_workers[self];
+  while (true) {
+    _start.arrive_and_wait();
+    if (_stopping) return;
+    drain(me, me, false);
+    for (std::size_t k = 1; k < _workers.size(); ++k) {
+      drain(me, *_workers[(self + k) % _workers.size()], true);
+    }
+    _done.arrive_and_wait();
+  }
+}
+
+void FleetExecutor::drain(Worker& worker, Worker& from, bool stealing) {
+  std::size_t size = from.queue.size();
+  for (std::size_t i = from.next.fetch_add(1, std::memory_order_relaxed); i < size;
+       i = from.next.fetch_add(1, std::memory_order_relaxed)) {
+    auto start = std::chrono::steady_clock::now();
+    _task(from.queue[i]);
+    worker.sync_latency.record(nanos_since(start));
+    ++worker.syncs;
+    worker.steals += stealing;
+  }
+}
+
+FleetStats FleetExecutor::stats() const {
+  FleetStats stats;
+  stats.ticks = _ticks;
+  stats.tick_latency = _tick_latency;
+  stats.busy = _busy;
+  for (auto const& worker : _workers) {
+    stats.steals += worker->steals;
+    stats.syncs += worker->syncs;
+    stats.sync_latency.merge(worker->sync_latency);
+  }
+  return stats;
+}
+
+void FleetExecutor::reset_stats() {
+  _ticks = 0;
+  _busy = {};
+  _tick_latency.reset();
+  for (auto& worker : _workers) {
+    worker->steals = 0;
+    worker->syncs = 0;
+    worker->sync_latency.reset();
+  }
+}
+
+} // namespace tickles
@@ -0,0 +1,129 @@
+#ifndef TICKLES_FLEET_H
+#define TICKLES_FLEET_H
+
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "histogram.h"
+
+namespace tickles {
+
+  struct FleetStats {
+    std::uint64_t ticks = 0;
+    // Instance syncs run by a worker other than the instance's home worker.
+    std::uint64_t steals = 0;
+    // Nanoseconds per instance sync, across all workers.
+    Histogram sync_latency;
+    // Nanoseconds per fleet tick, from release of the workers to the barrier.
+    Histogram tick_latency;
+    std::chrono::nanoseconds busy{0};
+    std::uint64_t syncs = 0;
+
+    double syncs_per_second() const {
+      return busy.count() ? 1e9 * static_cast<double>(syncs) / static_cast<double>(busy.count()) : 0;
+    }
+  };
+
+  // Runs a fixed set of tasks once per tick on a pool of worker threads.
+  //
+  // Every task has a home worker, which runs it whenever it can so that an
+  // instance's data stays in that core's cache. A worker that has finished
+  // its own queue steals from the others. Within a queue, tasks with higher
+  // priority run first. Each task runs exactly once per tick.
+  class FleetExecutor {
+  public:
+    explicit FleetExecutor(std::size_t workers = std::thread::hardware_concurrency());
+    FleetExecutor(FleetExecutor const&) = delete;
+    FleetExecutor(FleetExecutor &&) = delete;
+    ~FleetExecutor();
+
+    // Registers task number size() with the least loaded worker. Must not be
+    // called while run() is in progress.
+    std::size_t add(int priority = 0);
+    std::size_t size() const {return _priorities.size();}
+    std::size_t workers() const {return _workers.size();}
+
+    // Calls task(i) for every registered i and returns once all are done.
+    void run(std::function<void(std::size_t)> task);
+
+    FleetStats stats() const;
+    void reset_stats();
+
+  private:
+    struct alignas(64) Worker {
+      std::vector<std::size_t> queue;
+      std::atomic<std::size_t> next{0};
+      std::uint64_t steals = 0;
+      std::uint64_t syncs = 0;
+      Histogram sync_latency;
+      std::thread thread;
+    };
+
+    void work(std::size_t self);
+    void drain(Worker& worker, Worker& from, bool stealing);
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::vector<int> _priorities;
+    std::function<void(std::size_t)> _task;
+    std::barrier<> _start, _done;
+    bool _stopping = false;
+    std::uint64_t _ticks = 0;
+    std::chrono::nanoseconds _busy{0};
+    Histogram _tick_latency;
+  };
+
+  // Owns many independent instances (usually Autonomy subclasses) and ticks
+  // them all through a FleetExecutor. Each instance is only ever touched by
+  // one thread at a time; instances must not share state with each other,
+  // which Autonomy guarantees through its AutonomyScope.
+  template <typename AutonomyT>
+  class Fleet {
+  public:
+    explicit Fleet(std::size_t workers = std::thread::hardware_concurrency()) : _executor(workers) {}
+    Fleet(Fleet const&) = delete;
+    Fleet(Fleet &&) = delete;
+
+    AutonomyT& add(std::unique_ptr<AutonomyT> instance, int priority = 0) {
+      _executor.add(priority);
+      _instances.push_back(std::move(instance));
+      return *_instances.back();
+    }
+
+    template <typename... Args>
+    AutonomyT& emplace(Args&&... args) {
+      return add(std::make_unique<AutonomyT>(std::forward<Args>(args)...));
+    }
+
+    // Syncs every instance once; returns when all are done.
+    void tick() {
+      _executor.run([this](std::size_t i) {_instances[i]->sync();});
+    }
+
+    // Calls f on every instance, on the calling thread, between ticks.
+    template <typename F>
+    void for_each(F&& f) {
+      for (auto& instance : _instances) f(*instance);
+    }
+
+    std::size_t size() const {return _instances.size();}
+    AutonomyT& operator[](std::size_t i) {return *_instances[i];}
+
+    FleetStats stats() const {return _executor.stats();}
+    void reset_stats() {_executor.reset_stats();}
+
+  private:
+    FleetExecutor _executor;
+    std::vector<std::unique_ptr<AutonomyT>> _instances;
+  };
+
+} // namespace tickles
+
+#endif
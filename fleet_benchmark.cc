@@ -0,0 +1,74 @@
+#include "benchmark/benchmark.h"
+#include "autonomy.h"
+#include "behavior_tree.h"
+#include "fleet.h"
+#include "input.h"
+#include "mutable.h"
+
+using tickles::Autonomy;
+using tickles::FallBack;
+using tickles::Fleet;
+using tickles::Input;
+using tickles::Mutable;
+using tickles::Mutator;
+using tickles::Result;
+using tickles::Sequence;
+
+namespace {
+
+  struct Speed {
+    int value = 0;
+    bool operator==(Speed const&) const = default;
+  };
+
+  struct Near {
+    Input<int> const& position;
+    Result operator()() const {return position.get() < 100 ? Result::Succeeded : Result::Failed;}
+  };
+
+  struct Drive {
+    Input<int> const& position;
+    Mutator<Speed> speed;
+    Result operator()() const {
+      speed.set(Speed{(100 - position.get()) / 10});
+      return Result::Running;
+    }
+  };
+
+  struct Stop {
+    Mutator<Speed> speed;
+    Result operator()() const {
+      speed.set(Speed{0});
+      return Result::Succeeded;
+    }
+  };
+
+  struct Data {
+    std::shared_ptr<Input<int>> position;
+    std::shared_ptr<const Mutable<Speed>> speed;
+  };
+
+  struct Agent : Autonomy<Data, FallBack<Sequence<Near, Drive>, Stop>> {
+    using Autonomy::sync;
+  };
+
+}
+
+// Ticks a fleet of range(0) agents on range(1) workers.
+static void BM_FleetTick(benchmark::State& state) {
+  Fleet<Agent> fleet(static_cast<std::size_t>(state.range(1)));
+  for (int i = 0; i < state.range(0); ++i) fleet.emplace().data().position->set(i % 200);
+  int step = 0;
+  for (auto _ : state) {
+    fleet.for_each([&](Agent& agent) {agent.data().position->set((step++) % 200);});
+    fleet.tick();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["steals"] = static_cast<double>(fleet.stats().steals);
+}
+BENCHMARK(BM_FleetTick)
+  ->ArgsProduct({{1'000, 50'000}, {1, 2, 4, 8}})
+  ->UseRealTime()
+  ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
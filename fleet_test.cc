@@ -0,0 +1,101 @@
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "autonomy.h"
+#include "behavior_tree.h"
+#include "fleet.h"
+#include "input.h"
+#include "mutable.h"
+
+using tickles::Autonomy;
+using tickles::Fleet;
+using tickles::Input;
+using tickles::Mutable;
+using tickles::Mutator;
+using tickles::Result;
+using tickles::Sequence;
+
+namespace {
+
+  struct Counting {
+    int synced = 0;
+    void sync() {++synced;}
+  };
+
+  struct Doubled {
+    int value = 0;
+    bool operator==(Doubled const&) const = default;
+  };
+
+  struct Double {
+    Input<int> const& in;
+    Mutator<Doubled> out;
+    Result operator()() const {
+      out.set(Doubled{2 * in.get()});
+      return Result::Succeeded;
+    }
+  };
+
+  struct Data {
+    std::shared_ptr<Input<int>> in;
+    std::shared_ptr<const Mutable<Doubled>> out;
+  };
+
+  struct Doubler : Autonomy<Data, Sequence<Double>> {
+    using Autonomy::sync;
+  };
+
+}
+
+TEST(Fleet, SyncsEveryInstanceOncePerTick) {
+  Fleet<Counting> fleet(4);
+  for (int i = 0; i < 1000; ++i) fleet.emplace();
+  for (int t = 0; t < 10; ++t) fleet.tick();
+  fleet.for_each([](Counting const& c) {EXPECT_EQ(c.synced, 10);});
+  auto stats = fleet.stats();
+  EXPECT_EQ(stats.ticks, 10);
+  EXPECT_EQ(stats.syncs, 10'000);
+  EXPECT_EQ(stats.sync_latency.count(), 10'000);
+}
+
+TEST(Fleet, InstancesKeepTheirOwnState) {
+  Fleet<Doubler> fleet(3);
+  for (int i = 0; i < 100; ++i) fleet.emplace().data().in->set(i);
+  fleet.tick();
+  for (int i = 0; i < 100; ++i) EXPECT_EQ(fleet[i].data().out->get().value, 2 * i);
+}
+
+TEST(Fleet, HigherPriorityRunsFirstOnAWorker) {
+  struct Ordered {
+    std::vector<int>* order;
+    int id;
+    void sync() {order->push_back(id);}
+  };
+  std::vector<int> order;
+  Fleet<Ordered> fleet(1);
+  fleet.add(std::make_unique<Ordered>(Ordered{&order, 0}), 0);
+  fleet.add(std::make_unique<Ordered>(Ordered{&order, 1}), 5);
+  fleet.add(std::make_unique<Ordered>(Ordered{&order, 2}), 1);
+  fleet.add(std::make_unique<Ordered>(Ordered{&order, 3}), 5);
+  fleet.tick();
+  EXPECT_EQ(order, (std::vector<int>{1, 3, 2, 0}));
+}
+
+TEST(Fleet, IdleWorkersSteal) {
+  struct Slow {
+    std::atomic<int>* synced;
+    void sync() {
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+      ++*synced;
+    }
+  };
+  std::atomic<int> synced = 0;
+  Fleet<Slow> fleet(4);
+  // Keep every task on worker 0 by registering them before the others get any.
+  for (int i = 0; i < 64; ++i) fleet.add(std::make_unique<Slow>(Slow{&synced}));
+  fleet.tick();
+  EXPECT_EQ(synced, 64);
+  EXPECT_EQ(fleet.stats().syncs, 64);
+}
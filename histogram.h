@@ -0,0 +1,68 @@
+#ifndef TICKLES_HISTOGRAM_H
+#define TICKLES_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace tickles {
+
+  // Counts samples in fixed power-of-two buckets: bucket 0 holds zero and
+  // bucket b holds [2^(b-1), 2^b). Recording never allocates.
+  class Histogram {
+  public:
+    static constexpr std::size_t kBuckets = 48;
+
+    static std::size_t bucket_for(std::uint64_t value) {
+      return std::min<std::size_t>(std::bit_width(value), kBuckets - 1);
+    }
+
+    // Exclusive upper bound of bucket b.
+    static std::uint64_t upper_bound(std::size_t b) {
+      return std::uint64_t{1} << b;
+    }
+
+    void record(std::uint64_t value) {
+      ++_buckets[bucket_for(value)];
+      ++_count;
+      _sum += value;
+      _max = std::max(_max, value);
+    }
+
+    std::uint64_t count() const {return _count;}
+    std::uint64_t sum() const {return _sum;}
+    std::uint64_t max() const {return _max;}
+    std::uint64_t bucket(std::size_t b) const {return _buckets[b];}
+
+    // Upper bound of the bucket holding quantile q in [0, 1], capped at the
+    // largest sample seen.
+    std::uint64_t quantile(double q) const {
+      if (_count == 0) return 0;
+      auto rank = static_cast<std::uint64_t>(q * static_cast<double>(_count - 1)) + 1;
+      std::uint64_t seen = 0;
+      for (std::size_t b = 0; b < kBuckets; ++b) {
+	seen += _buckets[b];
+	if (seen >= rank) return std::min(_max, b == 0 ? 0 : upper_bound(b) - 1);
+      }
+      return _max;
+    }
+
+    void merge(Histogram const& other) {
+      for (std::size_t b = 0; b < kBuckets; ++b) _buckets[b] += other._buckets[b];
+      _count += other._count;
+      _sum += other._sum;
+      _max = std::max(_max, other._max);
+    }
+
+    void reset() {*this = Histogram{};}
+
+  private:
+    std::array<std::uint64_t, kBuckets> _buckets{};
+    std::uint64_t _count = 0, _sum = 0, _max = 0;
+  };
+
+} // namespace tickles
+
+#endif
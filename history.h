@@ -0,0 +1,92 @@
+#ifndef TICKLES_HISTORY_H
+#define TICKLES_HISTORY_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <iterator>
+
+#include "mutable.h"
+
+namespace tickles {
+
+  template <typename T>
+  struct Committed {
+    T value;
+    // On the clock of the Mutable's registry (see MutableRegistry::stamp_with()).
+    std::chrono::steady_clock::time_point at;
+  };
+
+  // The values a Mutable committed, newest first. Refers into the Mutable
+  // and is valid until its next sync().
+  template <typename T>
+  class History {
+  public:
+    History() = default;
+    History(Committed<T> const* ring, std::size_t capacity, std::size_t newest, std::size_t size)
+      : _ring(ring), _capacity(capacity), _newest(newest), _size(size) {}
+
+    std::size_t size() const {return _size;}
+    bool empty() const {return _size == 0;}
+    std::size_t capacity() const {return _capacity;}
+
+    // 0 is the latest commit.
+    Committed<T> const& operator[](std::size_t age) const {
+      return _ring[(_newest + _capacity - age) % _capacity];
+    }
+    Committed<T> const& newest() const {return (*this)[0];}
+    Committed<T> const& oldest() const {return (*this)[_size - 1];}
+
+    class iterator {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = Committed<T>;
+      using difference_type = std::ptrdiff_t;
+      using pointer = Committed<T> const*;
+      using reference = Committed<T> const&;
+
+      iterator() = default;
+      iterator(History const* history, std::size_t age) : _history(history), _age(age) {}
+      reference operator*() const {return (*_history)[_age];}
+      pointer operator->() const {return &(*_history)[_age];}
+      iterator& operator++() {++_age; return *this;}
+      iterator operator++(int) {iterator old = *this; ++_age; return old;}
+      bool operator==(iterator const& other) const {return _age == other._age;}
+
+    private:
+      History const* _history = nullptr;
+      std::size_t _age = 0;
+    };
+
+    iterator begin() const {return {this, 0};}
+    iterator end() const {return {this, _size};}
+
+  private:
+    Committed<T> const* _ring = nullptr;
+    std::size_t _capacity = 0;
+    std::size_t _newest = 0;
+    std::size_t _size = 0;
+  };
+
+  // What a Mutable keeps its history in, when mutable_history<T> asks for
+  // one.
+  template <typename T, std::size_t depth>
+  class HistoryRing {
+  public:
+    void push(T const& value, std::chrono::steady_clock::time_point at) {
+      _newest = _size ? (_newest + 1) % depth : 0;
+      _ring[_newest] = Committed<T>{value, at};
+      if (_size < depth) ++_size;
+    }
+
+    History<T> view() const {return {_ring.data(), depth, _newest, _size};}
+
+  private:
+    std::array<Committed<T>, depth> _ring{};
+    std::size_t _newest = 0;
+    std::size_t _size = 0;
+  };
+
+} // namespace tickles
+
+#endif
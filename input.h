@@ -0,0 +1,54 @@
+#ifndef TICKLES_INPUT_H
+#define TICKLES_INPUT_H
+
+#include <concepts>
+#include <cstdint>
+#include <utility>
+
+#include "checkpoint.h"
+
+namespace tickles {
+
+  // Anything that can tell whether it changed since it was last looked at.
+  template <typename T>
+  concept Versioned = requires (T const& t) {
+    {t.version()} -> std::convertible_to<std::uint64_t>;
+  };
+
+  // An input cell written by the owner of an Autonomy before sync() and read
+  // by the leaves. Unlike a Mutable there is no commit step: a set() is
+  // visible immediately and bumps the version.
+  template<typename T>
+  class Input {
+  public:
+    Input() = default;
+    Input(Input const&) = delete;
+    Input(Input &&) = delete;
+
+    template <typename U>
+    void set(U&& u) {
+      _value = std::forward<U>(u);
+      ++_version;
+    }
+
+    T const& get() const {return _value;}
+
+    std::uint64_t version() const {return _version;}
+
+  private:
+    std::uint64_t _version = 0;
+    T _value{};
+  };
+
+  template<Checkpointable T>
+  struct checkpoint_traits<Input<T>> {
+    static void save(CheckpointWriter& writer, Input<T> const& input) {writer.put(input.get());}
+    static void load(CheckpointReader& reader, Input<T>& input) {
+      T value = input.get();
+      if (reader.get(value)) input.set(std::move(value));
+    }
+  };
+
+} // namespace tickles
+
+#endif
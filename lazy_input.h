@@ -0,0 +1,87 @@
+#ifndef TICKLES_LAZY_INPUT_H
+#define TICKLES_LAZY_INPUT_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace tickles {
+
+  // Counts the ticks of one Autonomy, so that whatever is cached for the
+  // duration of a tick knows when that has ended. A tick is a whole sync(),
+  // every fixpoint pass included.
+  class TickEpoch {
+  public:
+    TickEpoch() = default;
+    TickEpoch(TickEpoch const&) = delete;
+    TickEpoch(TickEpoch &&) = delete;
+
+    std::uint64_t current() const {return _epoch;}
+    void advance() {++_epoch;}
+
+  private:
+    std::uint64_t _epoch = 1;
+  };
+
+  // An input that is pulled rather than pushed: the owner of the Autonomy
+  // gives it a provider once, and the provider runs the first time a leaf
+  // reads the input during a tick. Every later read in the same tick, in any
+  // pass, sees that value; ticks in which nothing reads it never call the
+  // provider at all. Meant for inputs that are costly to produce and that
+  // only some branches look at.
+  template <typename T>
+  class LazyInput {
+  public:
+    explicit LazyInput(std::shared_ptr<TickEpoch const> epoch) : _epoch(std::move(epoch)) {}
+    LazyInput(LazyInput const&) = delete;
+    LazyInput(LazyInput &&) = delete;
+
+    void provide(std::function<T()> provider) {
+      _provider = std::move(provider);
+      _provided_at = _epoch->current();
+      _value.reset();
+      _fetches = _hits = 0;
+    }
+
+    // Without a provider, a default T.
+    T const& get() const {
+      std::uint64_t epoch = _epoch->current();
+      if (_value && _fetched_at == epoch) {
+	++_hits;
+	return *_value;
+      }
+      _value = _provider ? _provider() : T{};
+      _fetched_at = epoch;
+      ++_fetches;
+      return *_value;
+    }
+
+    // Drops the cached value, so that the next read fetches again even
+    // within the same tick.
+    void invalidate() {_value.reset();}
+
+    std::uint64_t fetches() const {return _fetches;}
+    // Reads served from the value cached for the current tick.
+    std::uint64_t cache_hits() const {return _hits;}
+    // Ticks since provide() that never needed the provider; with eager
+    // pushing each of them would have been a fetch.
+    std::uint64_t fetches_avoided() const {
+      std::uint64_t ticks = _epoch->current() - _provided_at;
+      return ticks > _fetches ? ticks - _fetches : 0;
+    }
+
+  private:
+    std::shared_ptr<TickEpoch const> _epoch;
+    std::function<T()> _provider;
+    std::uint64_t _provided_at = 0;
+    mutable std::optional<T> _value;
+    mutable std::uint64_t _fetched_at = 0;
+    mutable std::uint64_t _fetches = 0;
+    mutable std::uint64_t _hits = 0;
+  };
+
+} // namespace tickles
+
+#endif
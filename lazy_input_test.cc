@@ -0,0 +1,101 @@
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "autonomy.h"
+#include "behavior_tree.h"
+#include "input.h"
+#include "lazy_input.h"
+#include "mutable.h"
+
+using tickles::Autonomy;
+using tickles::FallBack;
+using tickles::Input;
+using tickles::LazyInput;
+using tickles::Mutable;
+using tickles::Mutator;
+using tickles::Result;
+using tickles::Sequence;
+using tickles::TickEpoch;
+
+namespace {
+
+  struct Scan {
+    int nearest = 0;
+  };
+
+  struct Seen {
+    int nearest = 0;
+    bool operator==(Seen const&) const = default;
+  };
+
+  struct NotLooking {
+    Input<bool> const& looking;
+    Result operator()() const {return looking.get() ? Result::Failed : Result::Succeeded;}
+  };
+
+  // Reads the scan, and again in the pass its own write causes.
+  struct Look {
+    LazyInput<Scan> const& scan;
+    Mutator<Seen> seen;
+    Result operator()() const {
+      seen.set(Seen{scan.get().nearest});
+      return Result::Succeeded;
+    }
+  };
+
+  struct Data {
+    std::shared_ptr<Input<bool>> looking;
+    std::shared_ptr<LazyInput<Scan>> scan;
+    std::shared_ptr<Mutable<Seen> const> seen;
+  };
+
+  struct Scanner : Autonomy<Data, FallBack<NotLooking, Look>> {
+    using Autonomy::sync;
+  };
+
+}
+
+TEST(LazyInput, FetchesOncePerTick) {
+  auto epoch = std::make_shared<TickEpoch>();
+  LazyInput<Scan> scan(epoch);
+  int calls = 0;
+  scan.provide([&] {return Scan{++calls};});
+  EXPECT_EQ(scan.get().nearest, 1);
+  EXPECT_EQ(scan.get().nearest, 1);
+  epoch->advance();
+  EXPECT_EQ(scan.get().nearest, 2);
+  scan.invalidate();
+  EXPECT_EQ(scan.get().nearest, 3);
+  EXPECT_EQ(scan.fetches(), 3);
+  EXPECT_EQ(scan.cache_hits(), 1);
+}
+
+TEST(LazyInput, WithoutProviderReadsDefault) {
+  LazyInput<Scan> scan(std::make_shared<TickEpoch>());
+  EXPECT_EQ(scan.get().nearest, 0);
+}
+
+TEST(LazyInput, OnlyBranchesThatReadItFetch) {
+  Scanner scanner;
+  int calls = 0;
+  scanner.data().scan->provide([&] {return Scan{10 + ++calls};});
+
+  for (int i = 0; i < 5; ++i) scanner.sync();
+  EXPECT_EQ(calls, 0);
+
+  scanner.data().looking->set(true);
+  scanner.sync();
+  // Two passes, since Look's write makes the tree run again, but one fetch.
+  EXPECT_EQ(calls, 1);
+  EXPECT_EQ(scanner.data().scan->cache_hits(), 1);
+  EXPECT_EQ(scanner.data().seen->get().nearest, 11);
+
+  scanner.sync();
+  EXPECT_EQ(calls, 2);
+  EXPECT_EQ(scanner.data().seen->get().nearest, 12);
+
+  scanner.data().looking->set(false);
+  scanner.sync();
+  EXPECT_EQ(scanner.data().scan->fetches(), 2);
+  EXPECT_EQ(scanner.data().scan->fetches_avoided(), 6);
+}
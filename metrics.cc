@@ -0,0 +1,221 @@
+#include "metrics.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <type_traits>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace tickles {
+
+namespace {
+
+  std::atomic<std::uint64_t> next_registry_id{1};
+
+  // A cache line per slot array start, so that shards of different threads
+  // never share one.
+  constexpr std::size_t kCacheLine = 64;
+
+  std::string series_name(std::string const& name, std::string_view suffix, std::string const& labels,
+			  std::string_view extra = {}) {
+    std::string out = name;
+    out += suffix;
+    if (labels.empty() && extra.empty()) return out;
+    out += '{';
+    out += labels;
+    if (!labels.empty() && !extra.empty()) out += ',';
+    out += extra;
+    out += '}';
+    return out;
+  }
+
+} // namespace
+
+// Slots need no destruction, only the deallocation that matches their
+// aligned allocation.
+void MetricsRegistry::FreeSlots::operator()(std::atomic<std::uint64_t>* slots) const {
+  static_assert(std::is_trivially_destructible_v<std::atomic<std::uint64_t>>);
+  ::operator delete[](slots, std::align_val_t{kCacheLine});
+}
+
+MetricsRegistry::MetricsRegistry(std::size_t slots)
+  : _id(next_registry_id.fetch_add(1, std::memory_order_relaxed)), _capacity(slots) {}
+
+MetricsRegistry::~MetricsRegistry() {
+  Shard* shard = _shards.load(std::memory_order_acquire);
+  while (shard) {
+    Shard* next = shard->next;
+    delete shard;
+    shard = next;
+  }
+}
+
+MetricsRegistry& MetricsRegistry::global() {
+  static MetricsRegistry registry;
+  return registry;
+}
+
+Counter MetricsRegistry::counter(std::string_view name, std::string_view help, std::string_view labels) {
+  return Counter(this, add_series(name, help, labels, Type::Counter, 1));
+}
+
+LatencyHistogram MetricsRegistry::histogram(std::string_view name, std::string_view help, std::string_view labels) {
+  return LatencyHistogram(this, add_series(name, help, labels, Type::Histogram, LatencyHistogram::kSlots));
+}
+
+std::size_t MetricsRegistry::add_series(std::string_view name, std::string_view help, std::string_view labels,
+					Type type, std::size_t slots) {
+  std::lock_guard lock(_mutex);
+  Family* family = nullptr;
+  for (Family& f : _families) if (f.name == name) family = &f;
+  if (!family) family = &_families.emplace_back(Family{std::string(name), std::string(help), type, {}});
+  assert(family->type == type && "metric registered again with another type");
+  for (Series const& series : family->series) if (series.labels == labels) return series.slot;
+  // Running out of slots is a setup error; fall back on the last ones
+  // rather than writing out of bounds.
+  assert(_used + slots <= _capacity && "MetricsRegistry is full");
+  std::size_t slot = _used + slots <= _capacity ? _used : _capacity - slots;
+  _used = std::min(_capacity, _used + slots);
+  family->series.push_back(Series{std::string(labels), slot});
+  return slot;
+}
+
+std::atomic<std::uint64_t>* MetricsRegistry::attach_thread() {
+  std::lock_guard lock(_mutex);
+  auto self = std::this_thread::get_id();
+  Shard* shard = _shards.load(std::memory_order_acquire);
+  while (shard && shard->owner != self) shard = shard->next;
+  if (!shard) {
+    shard = new Shard{self, nullptr, _shards.load(std::memory_order_relaxed)};
+    auto* slots = static_cast<std::atomic<std::uint64_t>*>(
+        ::operator new[](_capacity * sizeof(std::atomic<std::uint64_t>), std::align_val_t{kCacheLine}));
+    std::uninitialized_value_construct_n(slots, _capacity);
+    shard->slots.reset(slots);
+    _shards.store(shard, std::memory_order_release);
+  }
+  _local = Local{_id, shard->slots.get()};
+  return shard->slots.get();
+}
+
+std::uint64_t MetricsRegistry::sum(std::size_t slot) const {
+  std::uint64_t total = 0;
+  for (Shard* shard = _shards.load(std::memory_order_acquire); shard; shard = shard->next) {
+    total += shard->slots[slot].load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+std::string MetricsRegistry::render() const {
+  std::lock_guard lock(_mutex);
+  std::ostringstream out;
+  out.precision(12);
+  for (Family const& family : _families) {
+    out << "# HELP " << family.name << ' ' << family.help << '\n';
+    out << "# TYPE " << family.name << (family.type == Type::Counter ? " counter\n" : " histogram\n");
+    for (Series const& series : family.series) {
+      if (family.type == Type::Counter) {
+	out << series_name(family.name, "", series.labels) << ' ' << sum(series.slot) << '\n';
+	continue;
+      }
+      std::uint64_t cumulative = 0;
+      for (std::size_t b = 0; b < LatencyHistogram::kBuckets; ++b) {
+	cumulative += sum(series.slot + b);
+	std::string le = "le=\"+Inf\"";
+	if (b + 1 < LatencyHistogram::kBuckets) {
+	  char bound[32];
+	  std::snprintf(bound, sizeof(bound), "le=\"%.12g\"",
+			static_cast<double>(Histogram::upper_bound(b + LatencyHistogram::kFirstBucket)) * 1e-9);
+	  le = bound;
+	}
+	out << series_name(family.name, "_bucket", series.labels, le) << ' ' << cumulative << '\n';
+      }
+      out << series_name(family.name, "_sum", series.labels) << ' '
+	  << static_cast<double>(sum(series.slot + LatencyHistogram::kBuckets)) * 1e-9 << '\n';
+      out << series_name(family.name, "_count", series.labels) << ' '
+	  << sum(series.slot + LatencyHistogram::kBuckets + 1) << '\n';
+    }
+  }
+  return out.str();
+}
+
+bool MetricsRegistry::write_file(std::string const& path) const {
+  std::string temporary = path + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::trunc);
+    file << render();
+    if (!file.flush()) return false;
+  }
+  return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+MetricsServer::MetricsServer(MetricsRegistry& registry, std::string path)
+  : _registry(registry), _path(std::move(path)) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (_path.size() >= sizeof(address.sun_path)) return;
+  std::memcpy(address.sun_path, _path.c_str(), _path.size() + 1);
+  if (::pipe(_wake) != 0) return;
+  _listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (_listener < 0) return;
+  ::unlink(_path.c_str());
+  if (::bind(_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      ::listen(_listener, 8) != 0) {
+    ::close(_listener);
+    _listener = -1;
+    return;
+  }
+  _thread = std::thread([this] {serve();});
+}
+
+MetricsServer::~MetricsServer() {
+  if (_thread.joinable()) {
+    char stop = 0;
+    [[maybe_unused]] auto written = ::write(_wake[1], &stop, 1);
+    _thread.join();
+  }
+  if (_listener >= 0) {
+    ::close(_listener);
+    ::unlink(_path.c_str());
+  }
+  for (int fd : _wake) if (fd >= 0) ::close(fd);
+}
+
+void MetricsServer::serve() {
+  while (true) {
+    pollfd fds[2] = {{_listener, POLLIN, 0}, {_wake[0], POLLIN, 0}};
+    if (::poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    if (fds[1].revents) return;
+    int client = ::accept4(_listener, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client < 0) continue;
+    // Drain whatever request the client sends first, if it sends one
+    // quickly, so that closing does not reset the connection.
+    pollfd request{client, POLLIN, 0};
+    if (::poll(&request, 1, 50) > 0) {
+      char ignored[1024];
+      [[maybe_unused]] auto got = ::recv(client, ignored, sizeof(ignored), MSG_DONTWAIT);
+    }
+    std::string body = _registry.render();
+    std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+      std::to_string(body.size()) + "\r\n\r\n" + body;
+    for (std::size_t sent = 0; sent < response.size();) {
+      auto n = ::send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+      if (n <= 0) break;
+      sent += static_cast<std::size_t>(n);
+    }
+    ::close(client);
+  }
+}
+
+} // namespace tickles
@@ -0,0 +1,214 @@
+#ifndef TICKLES_METRICS_H
+#define TICKLES_METRICS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "histogram.h"
+#include "tick_observer.h"
+
+namespace tickles {
+
+  class MetricsRegistry;
+
+  // A monotonically increasing count. Handles are cheap to copy and must
+  // not outlive their registry.
+  class Counter {
+  public:
+    void add(std::uint64_t n = 1) const;
+
+  private:
+    friend class MetricsRegistry;
+    Counter(MetricsRegistry* registry, std::size_t slot) : _registry(registry), _slot(slot) {}
+
+    MetricsRegistry* _registry;
+    std::size_t _slot;
+  };
+
+  // Latencies in nanoseconds, exported in seconds with power-of-two bucket
+  // bounds from about 1us to about 2s.
+  class LatencyHistogram {
+  public:
+    static constexpr std::size_t kFirstBucket = 10;
+    static constexpr std::size_t kLastBucket = 31;
+    // Finite buckets, then +Inf, the sum and the count.
+    static constexpr std::size_t kBuckets = kLastBucket - kFirstBucket + 2;
+    static constexpr std::size_t kSlots = kBuckets + 2;
+
+    void record(std::uint64_t nanoseconds) const;
+
+  private:
+    friend class MetricsRegistry;
+    LatencyHistogram(MetricsRegistry* registry, std::size_t slot) : _registry(registry), _slot(slot) {}
+
+    MetricsRegistry* _registry;
+    std::size_t _slot;
+  };
+
+  // Counters and histograms for export in the Prometheus text format.
+  //
+  // Every thread that records gets a shard of its own, aligned to a cache
+  // line, with one slot per counter and a few per histogram. Recording is a
+  // thread-local lookup and an uncontended relaxed add to the thread's own
+  // shard; no locks, no atomic read-modify-write. Rendering sums the slots
+  // across shards. Registering metrics takes a lock and is meant for
+  // setup; so is the first record on a new thread.
+  class MetricsRegistry {
+  public:
+    explicit MetricsRegistry(std::size_t slots = 4096);
+    MetricsRegistry(MetricsRegistry const&) = delete;
+    MetricsRegistry(MetricsRegistry &&) = delete;
+    ~MetricsRegistry();
+
+    // The registry AutonomyMetrics uses unless given another.
+    static MetricsRegistry& global();
+
+    // Registers the series name{labels}, or returns it if it exists.
+    // labels is written the Prometheus way, e.g. autonomy="left_arm".
+    Counter counter(std::string_view name, std::string_view help, std::string_view labels = {});
+    LatencyHistogram histogram(std::string_view name, std::string_view help, std::string_view labels = {});
+
+    std::uint64_t value(Counter counter) const {return sum(counter._slot);}
+    std::uint64_t count(LatencyHistogram histogram) const {
+      return sum(histogram._slot + LatencyHistogram::kBuckets + 1);
+    }
+
+    // Everything registered, in text exposition format 0.0.4.
+    std::string render() const;
+
+    // Writes render() to path through a temporary file and a rename, so a
+    // collector never reads half a file.
+    bool write_file(std::string const& path) const;
+
+    // This thread's shard. Only the last registry used on a thread is
+    // cached, so switching between registries on one thread is slow.
+    std::atomic<std::uint64_t>* local_slots() {
+      if (_local.registry == _id) return _local.slots;
+      return attach_thread();
+    }
+
+  private:
+    enum class Type {Counter, Histogram};
+    struct Series {
+      std::string labels;
+      std::size_t slot;
+    };
+    struct Family {
+      std::string name;
+      std::string help;
+      Type type;
+      std::vector<Series> series;
+    };
+    struct FreeSlots {
+      void operator()(std::atomic<std::uint64_t>* slots) const;
+    };
+    struct Shard {
+      std::thread::id owner;
+      std::unique_ptr<std::atomic<std::uint64_t>[], FreeSlots> slots;
+      Shard* next;
+    };
+    struct Local {
+      std::uint64_t registry;
+      std::atomic<std::uint64_t>* slots;
+    };
+
+    std::size_t add_series(std::string_view name, std::string_view help, std::string_view labels,
+			   Type type, std::size_t slots);
+    std::atomic<std::uint64_t>* attach_thread();
+    std::uint64_t sum(std::size_t slot) const;
+
+    std::uint64_t const _id;
+    std::size_t const _capacity;
+    std::size_t _used = 0;
+    mutable std::mutex _mutex;
+    std::vector<Family> _families;
+    std::atomic<Shard*> _shards = nullptr;
+
+    // Zero-initialized, like every thread_local; no registry has id 0.
+    static inline thread_local Local _local;
+  };
+
+  inline void Counter::add(std::uint64_t n) const {
+    std::atomic<std::uint64_t>& slot = _registry->local_slots()[_slot];
+    slot.store(slot.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  inline void LatencyHistogram::record(std::uint64_t nanoseconds) const {
+    std::atomic<std::uint64_t>* slots = _registry->local_slots() + _slot;
+    std::size_t b = Histogram::bucket_for(nanoseconds);
+    b = b <= kFirstBucket ? 0 : std::min(b - kFirstBucket, kBuckets - 1);
+    auto bump = [](std::atomic<std::uint64_t>& slot, std::uint64_t n) {
+      slot.store(slot.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    };
+    bump(slots[b], 1);
+    bump(slots[kBuckets], nanoseconds);
+    bump(slots[kBuckets + 1], 1);
+  }
+
+  // Counts syncs, tree passes and dirty commits, and times syncs, in
+  // registry under labels (e.g. robot="r2"), for the Autonomy that observes
+  // it (see Autonomy::observe()). Each sync_slice() call counts as a sync of
+  // its own.
+  class AutonomyMetrics : public TickObserver {
+  public:
+    explicit AutonomyMetrics(std::string_view labels = {}, MetricsRegistry& registry = MetricsRegistry::global())
+      : _syncs(registry.counter("tickles_ticks_total", "Calls to Autonomy::sync.", labels)),
+	_passes(registry.counter("tickles_fixpoint_iterations_total", "Behavior tree passes run by syncs.", labels)),
+	_dirty_commits(registry.counter("tickles_dirty_commits_total", "Mutable values committed with a new value.", labels)),
+	_latency(registry.histogram("tickles_sync_latency_seconds", "Time spent in one sync.", labels)) {}
+
+    void begin_sync(std::type_info const& tree, bool resuming) override {
+      _start = std::chrono::steady_clock::now();
+    }
+    void end_sync(std::type_info const& tree) override {
+      _syncs.add();
+      _latency.record(static_cast<std::uint64_t>(
+	  std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count()));
+    }
+    void end_pass(std::type_info const& tree) override {_passes.add();}
+    void end_commit(std::uint64_t committed, bool again) override {
+      if (committed) _dirty_commits.add(committed);
+    }
+
+  private:
+    Counter _syncs;
+    Counter _passes;
+    Counter _dirty_commits;
+    LatencyHistogram _latency;
+    std::chrono::steady_clock::time_point _start;
+  };
+
+  // Serves render() to whoever connects to a Unix domain socket, as an
+  // HTTP/1.0 response so that both curl --unix-socket and a plain socat
+  // work. One background thread; connections are answered one at a time.
+  class MetricsServer {
+  public:
+    MetricsServer(MetricsRegistry& registry, std::string path);
+    MetricsServer(MetricsServer const&) = delete;
+    MetricsServer(MetricsServer &&) = delete;
+    ~MetricsServer();
+
+    bool is_listening() const {return _listener >= 0;}
+
+  private:
+    void serve();
+
+    MetricsRegistry& _registry;
+    std::string _path;
+    int _listener = -1;
+    int _wake[2] = {-1, -1};
+    std::thread _thread;
+  };
+
+} // namespace tickles
+
+#endif
@@ -0,0 +1,170 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "autonomy.h"
+#include "behavior_tree.h"
+#include "input.h"
+#include "metrics.h"
+#include "mutable.h"
+
+using tickles::Autonomy;
+using tickles::AutonomyMetrics;
+using tickles::Input;
+using tickles::LatencyHistogram;
+using tickles::MetricsRegistry;
+using tickles::MetricsServer;
+using tickles::Mutable;
+using tickles::Mutator;
+using tickles::Result;
+using tickles::Sequence;
+
+namespace {
+
+  bool contains(std::string const& text, std::string const& line) {
+    return text.find(line) != std::string::npos;
+  }
+
+  struct Level {
+    int value = 0;
+    bool operator==(Level const&) const = default;
+  };
+
+  struct Target {
+    int value = 0;
+    bool operator==(Target const&) const = default;
+  };
+
+  // Copies the input to Level, then Level to Target: two passes per change.
+  struct CopyIn {
+    Input<int> const& in;
+    Mutator<Level> out;
+    Result operator()() const {
+      out.set(Level{in.get()});
+      return Result::Succeeded;
+    }
+  };
+
+  struct Follow {
+    Mutable<Level> const& level;
+    Mutator<Target> out;
+    Result operator()() const {
+      out.set(Target{level.get().value});
+      return Result::Succeeded;
+    }
+  };
+
+  struct Data {
+    std::shared_ptr<Input<int>> in;
+  };
+
+  struct Follower : Autonomy<Data, Sequence<CopyIn, Follow>> {
+    using Autonomy::sync;
+  };
+
+}
+
+TEST(Metrics, CountersSumAcrossThreads) {
+  MetricsRegistry registry;
+  auto counter = registry.counter("events_total", "Events.");
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([counter] {for (int i = 0; i < 10'000; ++i) counter.add();});
+  }
+  for (auto& thread : threads) thread.join();
+  counter.add(5);
+  EXPECT_EQ(registry.value(counter), 40'005);
+}
+
+TEST(Metrics, SeriesAreRegisteredOnce) {
+  MetricsRegistry registry;
+  auto a = registry.counter("events_total", "Events.", "robot=\"a\"");
+  auto b = registry.counter("events_total", "Events.", "robot=\"b\"");
+  a.add(2);
+  registry.counter("events_total", "Events.", "robot=\"a\"").add(3);
+  b.add();
+  EXPECT_EQ(registry.value(a), 5);
+  EXPECT_EQ(registry.value(b), 1);
+  std::string text = registry.render();
+  EXPECT_TRUE(contains(text, "# HELP events_total Events.\n# TYPE events_total counter\n"));
+  EXPECT_TRUE(contains(text, "events_total{robot=\"a\"} 5\n"));
+  EXPECT_TRUE(contains(text, "events_total{robot=\"b\"} 1\n"));
+}
+
+TEST(Metrics, HistogramBucketsAreCumulative) {
+  MetricsRegistry registry;
+  LatencyHistogram latency = registry.histogram("sync_seconds", "Sync time.");
+  latency.record(100);            // Below the first bound of 1024ns.
+  latency.record(3'000);          // In (2048, 4096].
+  latency.record(1'000'000'000);  // In (2^29, 2^30].
+  latency.record(10'000'000'000); // Past the last finite bound.
+  EXPECT_EQ(registry.count(latency), 4);
+  std::string text = registry.render();
+  EXPECT_TRUE(contains(text, "# TYPE sync_seconds histogram\n"));
+  EXPECT_TRUE(contains(text, "sync_seconds_bucket{le=\"1.024e-06\"} 1\n"));
+  EXPECT_TRUE(contains(text, "sync_seconds_bucket{le=\"2.048e-06\"} 1\n"));
+  EXPECT_TRUE(contains(text, "sync_seconds_bucket{le=\"4.096e-06\"} 2\n"));
+  EXPECT_TRUE(contains(text, "sync_seconds_bucket{le=\"1.073741824\"} 3\n"));
+  EXPECT_TRUE(contains(text, "sync_seconds_bucket{le=\"2.147483648\"} 3\n"));
+  EXPECT_TRUE(contains(text, "sync_seconds_bucket{le=\"+Inf\"} 4\n"));
+  EXPECT_TRUE(contains(text, "sync_seconds_count 4\n"));
+}
+
+TEST(Metrics, AutonomyExportsSyncsPassesAndCommits) {
+  MetricsRegistry registry;
+  AutonomyMetrics metrics("robot=\"f\"", registry);
+  Follower follower;
+  follower.sync();
+  follower.observe(&metrics);
+  follower.data().in->set(1);
+  follower.sync();
+  follower.sync();
+  std::string text = registry.render();
+  // The first sync commits Level, the second Target, the third nothing.
+  EXPECT_TRUE(contains(text, "tickles_ticks_total{robot=\"f\"} 2\n")) << text;
+  EXPECT_TRUE(contains(text, "tickles_fixpoint_iterations_total{robot=\"f\"} 4\n")) << text;
+  EXPECT_TRUE(contains(text, "tickles_dirty_commits_total{robot=\"f\"} 2\n")) << text;
+  EXPECT_TRUE(contains(text, "tickles_sync_latency_seconds_count{robot=\"f\"} 2\n")) << text;
+}
+
+TEST(Metrics, WritesFileAtomically) {
+  MetricsRegistry registry;
+  registry.counter("events_total", "Events.").add(7);
+  std::string path = ::testing::TempDir() + "metrics_test.prom";
+  ASSERT_TRUE(registry.write_file(path));
+  std::FILE* file = std::fopen(path.c_str(), "r");
+  ASSERT_NE(file, nullptr);
+  char buffer[256] = {};
+  std::fread(buffer, 1, sizeof(buffer) - 1, file);
+  std::fclose(file);
+  EXPECT_TRUE(contains(buffer, "events_total 7\n"));
+  std::remove(path.c_str());
+}
+
+TEST(Metrics, ServesOverUnixSocket) {
+  MetricsRegistry registry;
+  registry.counter("events_total", "Events.").add(3);
+  std::string path = ::testing::TempDir() + "metrics_test.sock";
+  MetricsServer server(registry, path);
+  ASSERT_TRUE(server.is_listening());
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::snprintf(address.sun_path, sizeof(address.sun_path), "%s", path.c_str());
+  ASSERT_EQ(::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+  std::string request = "GET /metrics HTTP/1.0\r\n\r\n";
+  ASSERT_EQ(::send(fd, request.data(), request.size(), 0), static_cast<ssize_t>(request.size()));
+  std::string response;
+  char buffer[512];
+  for (ssize_t n; (n = ::recv(fd, buffer, sizeof(buffer), 0)) > 0;) response.append(buffer, n);
+  ::close(fd);
+  EXPECT_EQ(response.rfind("HTTP/1.0 200 OK\r\n", 0), 0);
+  EXPECT_TRUE(contains(response, "\r\n\r\n# HELP events_total Events.\n"));
+  EXPECT_TRUE(contains(response, "events_total 3\n"));
+}
@@ -1,27 +1,217 @@
 #include "mutable.h"
 
-#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <thread>
+#include <utility>
 
 namespace tickles {
   
-MutableBase::MutableBase(std::shared_ptr<MutableRegistry> registry) : _registry(std::move(registry)){
-  _registry->add(this);
-}
+MutableBase::MutableBase(std::shared_ptr<MutableRegistry> registry, bool hooked)
+  : _registry(std::move(registry)), _hooked(hooked) {}
 
 MutableBase::~MutableBase() {
-  _registry->remove(this);
+  detach();
+}
+
+void MutableBase::attach() {
+  if (!_handle) _handle = _registry->add(this);
+}
+
+void MutableBase::detach() {
+  if (_handle) _registry->remove(*std::exchange(_handle, std::nullopt));
+}
+
+namespace {
+  // Chunk and offset within it of a slot index.
+  struct ChunkOffset {
+    std::size_t chunk;
+    std::size_t offset;
+    std::size_t size;
+  };
+
+  template <std::uint32_t first_bits>
+  ChunkOffset chunk_of(std::uint32_t index) {
+    std::uint64_t shifted = std::uint64_t{index} + (std::uint64_t{1} << first_bits);
+    std::size_t chunk = std::bit_width(shifted) - 1 - first_bits;
+    std::size_t size = std::size_t{1} << (chunk + first_bits);
+    return {chunk, shifted - size, size};
+  }
+}
+
+MutableRegistry::~MutableRegistry() {
+  for (auto& chunk : _chunks) delete[] chunk.load();
+}
+
+MutableRegistry::Slot& MutableRegistry::slot(std::uint32_t index) {
+  auto [chunk, offset, size] = chunk_of<kFirstChunkBits>(index);
+  Slot* slots = _chunks[chunk].load(std::memory_order_acquire);
+  if (!slots) {
+    // Racing allocators agree on whichever chunk got there first.
+    auto* fresh = new Slot[size];
+    if (_chunks[chunk].compare_exchange_strong(slots, fresh, std::memory_order_acq_rel)) slots = fresh;
+    else delete[] fresh;
+  }
+  return slots[offset];
+}
+
+MutableRegistry::Slot const* MutableRegistry::find(std::uint32_t index) const {
+  if (index >= _next_index.load(std::memory_order_relaxed)) return nullptr;
+  auto [chunk, offset, size] = chunk_of<kFirstChunkBits>(index);
+  Slot const* slots = _chunks[chunk].load(std::memory_order_acquire);
+  return slots ? &slots[offset] : nullptr;
+}
+
+std::uint32_t MutableRegistry::allocate() {
+  std::uint64_t head = _free.load(std::memory_order_acquire);
+  while (static_cast<std::uint32_t>(head) != kNone) {
+    auto index = static_cast<std::uint32_t>(head);
+    std::uint64_t next = (head >> 32 << 32) + (std::uint64_t{1} << 32) +
+      slot(index).next_free.load(std::memory_order_relaxed);
+    if (_free.compare_exchange_weak(head, next, std::memory_order_acquire)) return index;
+  }
+  std::uint32_t index = _next_index.fetch_add(1, std::memory_order_relaxed);
+  assert(index != kNone && "MutableRegistry is full");
+  return index;
+}
+
+void MutableRegistry::free(std::uint32_t index) {
+  Slot& s = slot(index);
+  std::uint64_t head = _free.load(std::memory_order_relaxed);
+  do {
+    s.next_free.store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+  } while (!_free.compare_exchange_weak(head, (head >> 32 << 32) + (std::uint64_t{1} << 32) + index,
+					std::memory_order_release));
+}
+
+MutableRegistry::Shard& MutableRegistry::shard(std::array<Shard, kShards>& shards) {
+  static std::atomic<std::size_t> next_shard = 0;
+  static thread_local std::size_t mine = next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+  return shards[mine];
+}
+
+void MutableRegistry::push(std::atomic<std::uint32_t>& head, std::atomic<std::uint32_t>& next, std::uint32_t index) {
+  std::uint32_t first = head.load(std::memory_order_relaxed);
+  do {
+    next.store(first, std::memory_order_relaxed);
+  } while (!head.compare_exchange_weak(first, index));
+}
+
+MutableHandle MutableRegistry::add(MutableBase* a) {
+  std::uint32_t index = allocate();
+  Slot& s = slot(index);
+  s.mut = a;
+  push(shard(_pending).added, s.next_added, index);
+  return {index, s.generation};
+}
+
+void MutableRegistry::remove(MutableHandle handle) {
+  Slot& s = slot(handle.index);
+  assert(s.generation == handle.generation && s.mut && "stale MutableHandle");
+  push(shard(_pending).removed, s.next_removed, handle.index);
+  // A walk that started before the push may still reach the Mutable; the
+  // next one merges the removal first.
+  std::uint64_t walking = _walking.load();
+  if (walking % 2 == 0) return;
+  while (_walking.load(std::memory_order_acquire) == walking) std::this_thread::yield();
 }
 
-void MutableRegistry::add(MutableBase* a) {
-  _as.insert(a);
+bool MutableRegistry::contains(MutableHandle handle) const {
+  Slot const* s = find(handle.index);
+  return s && s->generation == handle.generation && s->dense != kNone;
 }
 
-void MutableRegistry::remove(MutableBase* a) {
-  _as.erase(a);
+MutableBase* MutableRegistry::get(MutableHandle handle) const {
+  Slot const* s = find(handle.index);
+  return s && s->generation == handle.generation && s->dense != kNone ? s->mut : nullptr;
 }
 
+// Applies what add() and remove() left pending. Removals are taken first,
+// so that every one of them finds its Mutable already added, either in an
+// earlier merge or in this one.
+void MutableRegistry::merge() {
+  std::array<std::uint32_t, kShards> removed, added;
+  for (std::size_t i = 0; i < kShards; ++i) {
+    removed[i] = _pending[i].removed.load() == kNone ? kNone : _pending[i].removed.exchange(kNone);
+  }
+  for (std::size_t i = 0; i < kShards; ++i) {
+    added[i] = _pending[i].added.load() == kNone ? kNone : _pending[i].added.exchange(kNone);
+  }
+  for (std::uint32_t first : added) {
+    for (std::uint32_t index = first; index != kNone;) {
+      Slot& s = slot(index);
+      s.dense = static_cast<std::uint32_t>(_dense.size());
+      _dense.push_back(s.mut);
+      _dense_slots.push_back(index);
+      index = s.next_added.load(std::memory_order_relaxed);
+    }
+  }
+  for (std::uint32_t first : removed) {
+    for (std::uint32_t index = first; index != kNone;) {
+      Slot& s = slot(index);
+      std::uint32_t next = s.next_removed.load(std::memory_order_relaxed);
+      _dense[s.dense] = _dense.back();
+      _dense_slots[s.dense] = _dense_slots.back();
+      slot(_dense_slots[s.dense]).dense = s.dense;
+      _dense.pop_back();
+      _dense_slots.pop_back();
+      s.mut = nullptr;
+      s.dense = kNone;
+      ++s.generation;
+      free(index);
+      index = next;
+    }
+  }
+}
+
+// Commits every Mutable, so that all the writes of a pass become visible
+// together. In an ordered pass those of hooked types have been visible all
+// along, and only the ones that changed after being read call for another
+// pass, which evaluates the whole tree again in the same order; a changed
+// value of any other type always does.
 bool MutableRegistry::sync() {
-  return std::ranges::any_of(_as, [](MutableBase* mut) {return mut->sync();});
+  _walking.fetch_add(1);
+  merge();
+  _commit_time.reset();
+  TickObserver* observer = TickObserver::current();
+  if (observer) observer->begin_commit();
+  bool ordered = OrderedPass::current();
+  std::uint64_t committed = 0, rerun = 0;
+  for (std::size_t i = 0; i < _dense.size(); ++i) {
+    MutableBase* mut = _dense[i];
+    bool was_stale = mut->take_stale();
+    if (!mut->sync()) continue;
+    ++committed;
+    bool again = !ordered || !mut->hooked() || was_stale;
+    rerun += again;
+    if (_recording) _committed.push_back(MutableHandle{_dense_slots[i], slot(_dense_slots[i]).generation});
+    if (observer) observer->committed(*mut, mut->value_type(), again);
+  }
+  _walking.fetch_add(1, std::memory_order_release);
+  bool again = rerun != 0;
+  if (observer) observer->end_commit(committed, again);
+  return again;
+}
+
+std::chrono::steady_clock::time_point MutableRegistry::commit_time() {
+  if (!_commit_time) _commit_time = _clock ? _clock() : std::chrono::steady_clock::now();
+  return *_commit_time;
+}
+
+void MutableRegistry::update() {
+  _walking.fetch_add(1);
+  merge();
+  _walking.fetch_add(1, std::memory_order_release);
+}
+
+void MutableRegistry::discard() {
+  _walking.fetch_add(1);
+  merge();
+  for (MutableBase* mut : _dense) {
+    mut->discard();
+    mut->take_stale();
+  }
+  _walking.fetch_add(1, std::memory_order_release);
 }
 
 } // namespace tickles
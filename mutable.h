@@ -1,9 +1,22 @@
 #ifndef TICKLES_MUTABLE_H
 #define TICKLES_MUTABLE_H
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
-#include <unordered_set>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
 
+#include "checkpoint.h"
+#include "tick_observer.h"
 #include "boost/di.hpp"
 
 namespace tickles {
@@ -11,57 +24,344 @@ namespace tickles {
 
   class MutableBase;
 
+  // How many committed values the Mutables of a value type remember. None
+  // by default; opt in, after including history.h, with
+  //
+  //   template <> struct tickles::mutable_history<Speed> {static constexpr std::size_t depth = 16;};
+  //
+  // The ring is stored inside the Mutable, so it never allocates.
+  template <typename T>
+  struct mutable_history {
+    static constexpr std::size_t depth = 0;
+  };
+
+  // Whether the Mutables of a value type report their reads and writes to
+  // TickObservers and take part in ordered passes (see OrderedPass). Off by
+  // default, so that get() and set() stay a plain field read and write; opt
+  // in with
+  //
+  //   template <> struct tickles::mutable_hooks<Goal> {static constexpr bool enabled = true;};
+  //
+  // Under evaluate_in_order(), the other types behave as they do in sync():
+  // get() sees the last commit, and committing a change asks for another
+  // pass.
+  template <typename T>
+  struct mutable_hooks {
+    static constexpr bool enabled = false;
+  };
+
+  // Defined in history.h.
+  template <typename T>
+  class History;
+  template <typename T, std::size_t depth>
+  class HistoryRing;
+
+  // Installed by an Autonomy for the duration of a sync() that evaluates in
+  // order. While one is installed on the tick thread, the get() and
+  // version() of a Mutable whose type takes mutable_hooks describe the
+  // latest value set() in the current pass, so leaves see what leaves ticked
+  // before them wrote without waiting for the commit. A set() that changes a
+  // value something already read in the same pass marks it stale, and only
+  // stale Mutables, and changed ones of other types, make the
+  // MutableRegistry ask for another pass.
+  class OrderedPass {
+  public:
+    class Install {
+    public:
+      explicit Install(OrderedPass* pass) : _previous(_current) {_current = pass;}
+      Install(Install const&) = delete;
+      ~Install() {_current = _previous;}
+    private:
+      OrderedPass* _previous;
+    };
+
+    static OrderedPass* current() {return _current;}
+
+    void begin() {++_epoch;}
+    std::uint64_t epoch() const {return _epoch;}
+
+  private:
+    // Mutables start out read in epoch 0, which no pass has.
+    std::uint64_t _epoch = 1;
+
+    static inline thread_local OrderedPass* _current = nullptr;
+  };
+
+  // Names a Mutable's slot in its MutableRegistry. The generation changes
+  // every time the slot is freed, so a handle kept past remove() is stale.
+  struct MutableHandle {
+    std::uint32_t index;
+    std::uint32_t generation;
+  };
+
+  // Mutables may be created and destroyed on any thread, while sync() and
+  // discard() belong to the tick thread.
+  //
+  // Registered Mutables live in a generational slot map: add() hands out a
+  // slot index (reusing freed ones first) and remove() names it, with no
+  // hashing, and sync() walks a dense array of the live ones. Slots are kept
+  // in chunks that never move and are recycled, so churning subtrees does
+  // not allocate once the registry has grown to fit them.
+  //
+  // add() and remove() never touch the dense array. They push the slot onto
+  // one of a few lock-free stacks, picked by thread so that loader threads
+  // building trees in parallel rarely share one, and sync() merges whatever
+  // is pending before it commits. The tick thread never waits. remove() may:
+  // it returns only once no commit that could still see the Mutable is in
+  // progress, so a Mutable may be destroyed while the tick thread syncs.
   class MutableRegistry {
   public:
     MutableRegistry() {}
     MutableRegistry(MutableRegistry const&) = delete;
     MutableRegistry(MutableRegistry &&) = delete;
+    ~MutableRegistry();
 
-    void add(MutableBase* a);
-    void remove(MutableBase* a);
+    MutableHandle add(MutableBase* a);
+    void remove(MutableHandle handle);
     bool sync();
+    // Drops every pending set() without committing it.
+    void discard();
+    // Takes in what add() and remove() left pending, as sync() and discard()
+    // do first, for a registry that is read but never synced.
+    void update();
+
+    // The clock whose time sync() stamps on the values it commits into
+    // Mutable histories; steady_clock unless an Autonomy sets its own.
+    void stamp_with(std::function<std::chrono::steady_clock::time_point()> clock) {
+      _clock = std::move(clock);
+    }
+    // The time of the commit in progress, read from that clock the first
+    // time a Mutable asks for it.
+    std::chrono::steady_clock::time_point commit_time();
+
+    // Registered Mutables, as of the last sync() or discard(). Tick thread
+    // only, like everything below.
+    std::size_t size() const {return _dense.size();}
+    std::span<MutableBase* const> mutables() const {return _dense;}
+    bool contains(MutableHandle handle) const;
+    // The Mutable handle names, or null if the handle is stale.
+    MutableBase* get(MutableHandle handle) const;
+
+    // While on, sync() appends the handle of every Mutable it commits with a
+    // new value to committed(), until clear_committed().
+    void record_commits(bool on) {_recording = on;}
+    std::span<MutableHandle const> committed() const {return _committed;}
+    void clear_committed() {_committed.clear();}
+
   private:
-    std::unordered_set<MutableBase*> _as;
+    static constexpr std::uint32_t kNone = ~std::uint32_t{0};
+
+    struct Slot {
+      MutableBase* mut = nullptr;
+      std::uint32_t generation = 0;
+      // Position in _dense, while registered.
+      std::uint32_t dense = kNone;
+      std::atomic<std::uint32_t> next_free = kNone;
+      std::atomic<std::uint32_t> next_added = kNone;
+      std::atomic<std::uint32_t> next_removed = kNone;
+    };
+
+    // Chunk c holds kFirstChunk << c slots, so 26 chunks cover every index.
+    static constexpr std::uint32_t kFirstChunkBits = 6;
+    static constexpr std::size_t kChunks = 32 - kFirstChunkBits;
+
+    struct alignas(64) Shard {
+      std::atomic<std::uint32_t> added = kNone;
+      std::atomic<std::uint32_t> removed = kNone;
+    };
+    static constexpr std::size_t kShards = 16;
+
+    Slot& slot(std::uint32_t index);
+    Slot const* find(std::uint32_t index) const;
+    std::uint32_t allocate();
+    void free(std::uint32_t index);
+    static Shard& shard(std::array<Shard, kShards>& shards);
+    static void push(std::atomic<std::uint32_t>& head, std::atomic<std::uint32_t>& next, std::uint32_t index);
+    void merge();
+
+    std::array<std::atomic<Slot*>, kChunks> _chunks{};
+    std::atomic<std::uint32_t> _next_index = 0;
+    // Index of the first free slot, tagged in the upper half against ABA.
+    std::atomic<std::uint64_t> _free = kNone;
+    std::array<Shard, kShards> _pending;
+    // Odd while sync() or discard() walks _dense.
+    std::atomic<std::uint64_t> _walking = 0;
+    std::vector<MutableBase*> _dense;
+    std::vector<std::uint32_t> _dense_slots;
+    bool _recording = false;
+    std::vector<MutableHandle> _committed;
+    std::function<std::chrono::steady_clock::time_point()> _clock;
+    std::optional<std::chrono::steady_clock::time_point> _commit_time;
   };
 
   class MutableBase {
   public:
-    MutableBase(std::shared_ptr<MutableRegistry> registry);
+    MutableBase(std::shared_ptr<MutableRegistry> registry, bool hooked = false);
     MutableBase(MutableBase const&) = delete;
     MutableBase(MutableBase &&) = delete;
     virtual ~MutableBase();
     virtual bool sync() = 0;
+    virtual void discard() = 0;
+    virtual std::type_info const& value_type() const = 0;
+    // Write or replace the committed value, for Checkpointable value types;
+    // false for the others.
+    virtual bool save_value(CheckpointWriter& writer) const = 0;
+    virtual bool load_value(CheckpointReader& reader) = 0;
+
+    // Whether an ordered pass changed the value after reading it; clears it.
+    bool take_stale() {return std::exchange(_stale, false);}
+    // Whether the value type takes mutable_hooks.
+    bool hooked() const {return _hooked;}
+
+    std::optional<MutableHandle> const& handle() const {return _handle;}
+
+  protected:
+    // Registration, which makes the tick thread call the virtuals above, is
+    // left to the most derived class: it attaches once it is fully built
+    // and detaches before it starts being destroyed.
+    void attach();
+    void detach();
+
+    MutableRegistry& registry() const {return *_registry;}
+
+    // For hooked types only; read_epoch is the epoch of the ordered pass
+    // that last read the value.
+    void note_writer(std::uint64_t read_epoch) {
+      if (OrderedPass* pass = OrderedPass::current()) _stale |= read_epoch == pass->epoch();
+      if (TickObserver* observer = TickObserver::current()) observer->wrote(*this);
+    }
+
+    void note_reader() const {
+      if (TickObserver* observer = TickObserver::current()) observer->read(*this);
+    }
 
   private:
     std::shared_ptr<MutableRegistry> _registry;
+    bool _hooked;
+    bool _stale = false;
+    std::optional<MutableHandle> _handle;
   };
   
   template<typename T>
   class Mutable : public MutableBase {
   public:    
-    Mutable(std::shared_ptr<MutableRegistry> registry) : MutableBase(registry) {}
+    Mutable(std::shared_ptr<MutableRegistry> registry) : MutableBase(registry, kHooked) {attach();}
     Mutable(const Mutable&) = delete;
     Mutable(Mutable&&) = delete;
+    ~Mutable() override {detach();}
 
     template <typename U>
     void set(U&& u) {
       if (u == _next) return;
       _dirty = true;
       _next = std::move(u);
+      if constexpr (kHooked) {
+	_ordering.next_version = ++_ordering.versions;
+	note_writer(_ordering.read_epoch);
+      }
     }
 
-    T const& get() const {return _last;}
+    T const& get() const {
+      if constexpr (kHooked) {
+	if (read_in_order()) return _next;
+      }
+      return _last;
+    }
+
+    // Names the value get() returns, and never names another: it changes
+    // every time sync() commits a changed value and, for hooked types in an
+    // ordered pass, every time set() changes the value. Reading it in an
+    // ordered pass counts as reading the value, so that a node that skips
+    // work while the version stays the same is ticked again if the value
+    // changes after.
+    std::uint64_t version() const {
+      if constexpr (kHooked) {
+	if (read_in_order()) return _ordering.next_version;
+      }
+      return _version;
+    }
     
     bool sync() override {
       _last = _next;
       bool was_dirty = _dirty;
       _dirty = false;
+      if constexpr (kHooked) _version = _ordering.next_version;
+      else _version += was_dirty;
+      if constexpr (kHistoryDepth > 0) {
+	if (was_dirty) _history.push(_last, registry().commit_time());
+      }
       return was_dirty;
     }
 
+    // Changed values committed by sync(), if mutable_history<T> asks for
+    // them; needs history.h.
+    History<T> history() const {
+      if constexpr (kHistoryDepth > 0) return _history.view();
+      else return {};
+    }
+
+    void discard() override {
+      _next = _last;
+      _dirty = false;
+      if constexpr (kHooked) _ordering.next_version = _version;
+    }
+
+    // Replaces the committed value outright, as when restoring a checkpoint.
+    void restore(T value) {
+      _last = _next = std::move(value);
+      _dirty = false;
+      if constexpr (kHooked) _version = _ordering.next_version = ++_ordering.versions;
+      else ++_version;
+    }
+
+    std::type_info const& value_type() const override {return typeid(T);}
+
+    bool save_value(CheckpointWriter& writer) const override {
+      if constexpr (Checkpointable<T>) {
+	writer.put(_last);
+	return !writer.overflowed();
+      }
+      return false;
+    }
+
+    bool load_value(CheckpointReader& reader) override {
+      if constexpr (Checkpointable<T>) {
+	T value = _last;
+	if (!reader.get(value)) return false;
+	restore(std::move(value));
+	return true;
+      }
+      return false;
+    }
+
   private:
+    static constexpr std::size_t kHistoryDepth = mutable_history<T>::depth;
+    static constexpr bool kHooked = mutable_hooks<T>::enabled;
+
+    // Whether an ordered pass is reading _next; notes the read if so.
+    bool read_in_order() const {
+      OrderedPass const* pass = OrderedPass::current();
+      if (!pass) return false;
+      _ordering.read_epoch = pass->epoch();
+      note_reader();
+      return true;
+    }
+
     bool _dirty = false;
+    // That of _last.
+    std::uint64_t _version = 0;
     T _last{}, _next{};
+    // What hooked types keep for ordered passes: the version of _next, out
+    // of the versions handed out so far, and the epoch of the pass that last
+    // read the value, from 0, which no pass has.
+    struct Ordering {
+      std::uint64_t next_version = 0, versions = 0;
+      std::uint64_t read_epoch = 0;
+    };
+    struct NoOrdering {};
+    [[no_unique_address]] mutable std::conditional_t<kHooked, Ordering, NoOrdering> _ordering;
+    struct NoHistory {};
+    [[no_unique_address]] std::conditional_t<kHistoryDepth == 0, NoHistory, HistoryRing<T, kHistoryDepth>> _history;
   };
   
   template<typename T>
@@ -76,10 +376,24 @@ namespace tickles {
     void set(U&& u) const {_mutable->set(std::forward<U>(u));}
 
     T const& get() const {return _mutable->get();}
+
+    std::uint64_t version() const {return _mutable->version();}
+
+    History<T> history() const {return _mutable->history();}
     
   private:
     std::shared_ptr<Mutable<T>> _mutable;
   };
+
+  // A Mutable is checkpointed by its committed value.
+  template<Checkpointable T>
+  struct checkpoint_traits<Mutable<T>> {
+    static void save(CheckpointWriter& writer, Mutable<T> const& mut) {writer.put(mut.get());}
+    static void load(CheckpointReader& reader, Mutable<T>& mut) {
+      T value = mut.get();
+      if (reader.get(value)) mut.restore(std::move(value));
+    }
+  };
 }
 
 #endif
@@ -0,0 +1,91 @@
+#include <cstdint>
+#include <memory>
+
+#include "benchmark/benchmark.h"
+#include "behavior_tree.h"
+#include "mutable.h"
+
+using tickles::HookedSequence;
+using tickles::Mutable;
+using tickles::MutableRegistry;
+using tickles::Mutator;
+using tickles::Result;
+using tickles::Sequence;
+
+// What the tick hooks cost while nothing is installed: plain Mutables and
+// static composites against hooked ones.
+
+namespace {
+
+  struct Count {
+    std::uint64_t value = 0;
+    bool operator==(Count const&) const = default;
+  };
+
+  struct HookedCount : Count {};
+
+}
+
+template <>
+struct tickles::mutable_hooks<HookedCount> {static constexpr bool enabled = true;};
+
+namespace {
+
+  // Reads and bumps its own Mutable, as most leaves read a few and write
+  // one.
+  template <typename T, int i>
+  struct Bump {
+    Mutator<T> count;
+    Result operator()() const {
+      count.set(T{{count.get().value + 1}});
+      return Result::Succeeded;
+    }
+  };
+
+  template <typename T, int... i>
+  using Bumps = Sequence<Bump<T, i>...>;
+
+  template <typename T, int... i>
+  using HookedBumps = HookedSequence<Bump<T, i>...>;
+
+}
+
+template <typename T>
+static void BM_MutableGet(benchmark::State& state) {
+  auto registry = std::make_shared<MutableRegistry>();
+  Mutable<T> count(registry);
+  for (auto _ : state) benchmark::DoNotOptimize(count.get());
+}
+BENCHMARK_TEMPLATE(BM_MutableGet, Count);
+BENCHMARK_TEMPLATE(BM_MutableGet, HookedCount);
+
+template <typename T>
+static void BM_MutableSet(benchmark::State& state) {
+  auto registry = std::make_shared<MutableRegistry>();
+  Mutable<T> count(registry);
+  std::uint64_t value = 0;
+  for (auto _ : state) count.set(T{{++value}});
+  benchmark::DoNotOptimize(count.version());
+}
+BENCHMARK_TEMPLATE(BM_MutableSet, Count);
+BENCHMARK_TEMPLATE(BM_MutableSet, HookedCount);
+
+// Eight leaves under one composite, then the commit.
+template <typename Tree, typename T>
+static void BM_TickAndSync(benchmark::State& state) {
+  auto registry = std::make_shared<MutableRegistry>();
+  std::shared_ptr<Mutable<T>> counts[8];
+  for (auto& count : counts) count = std::make_shared<Mutable<T>>(registry);
+  Tree tree(Bump<T, 0>{Mutator<T>(counts[0])}, Bump<T, 1>{Mutator<T>(counts[1])},
+	    Bump<T, 2>{Mutator<T>(counts[2])}, Bump<T, 3>{Mutator<T>(counts[3])},
+	    Bump<T, 4>{Mutator<T>(counts[4])}, Bump<T, 5>{Mutator<T>(counts[5])},
+	    Bump<T, 6>{Mutator<T>(counts[6])}, Bump<T, 7>{Mutator<T>(counts[7])});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tree());
+    registry->sync();
+  }
+}
+BENCHMARK_TEMPLATE(BM_TickAndSync, Bumps<Count, 0, 1, 2, 3, 4, 5, 6, 7>, Count);
+BENCHMARK_TEMPLATE(BM_TickAndSync, HookedBumps<HookedCount, 0, 1, 2, 3, 4, 5, 6, 7>, HookedCount);
+
+BENCHMARK_MAIN();
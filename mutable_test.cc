@@ -1,3 +1,10 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "history.h"
 #include "mutable.h"
 #include "boost/di.hpp"
 #include "gtest/gtest.h"
@@ -61,3 +68,205 @@ TEST(Mutable, CanSyncThroughRegistry) {
   EXPECT_EQ(43, mutable_int->get());
 }
 
+
+TEST(Mutable, DiscardDropsPendingSet) {
+  auto registry = std::make_shared<MutableRegistry>();
+  Mutable<int> mutable_int(registry);
+  mutable_int.set(42);
+  registry->discard();
+  EXPECT_EQ(false, registry->sync());
+  EXPECT_EQ(0, mutable_int.get());
+}
+
+TEST(Mutable, RegistryCommitsEveryDirtyMutable) {
+  auto registry = std::make_shared<MutableRegistry>();
+  Mutable<int> a(registry), b(registry);
+  a.set(1);
+  b.set(2);
+  EXPECT_EQ(true, registry->sync());
+  EXPECT_EQ(1, a.get());
+  EXPECT_EQ(2, b.get());
+  EXPECT_EQ(false, registry->sync());
+}
+
+namespace {
+  struct Sample {
+    int value = 0;
+    bool operator==(Sample const&) const = default;
+  };
+}
+
+template <> struct tickles::mutable_history<Sample> {static constexpr std::size_t depth = 3;};
+
+namespace {
+  struct Goal {
+    int value = 0;
+    bool operator==(Goal const&) const = default;
+  };
+
+  struct Writes : TickObserver {
+    int writes = 0;
+    void wrote(MutableBase const& mut) override {++writes;}
+  };
+}
+
+template <> struct tickles::mutable_hooks<Goal> {static constexpr bool enabled = true;};
+
+// Plain types keep no state for ordered passes.
+static_assert(sizeof(Mutable<Goal>) > sizeof(Mutable<int>));
+
+TEST(Mutable, HookedTypesShowWritesWithinOrderedPass) {
+  auto registry = std::make_shared<MutableRegistry>();
+  Mutable<Goal> goal(registry);
+  Writes writes;
+  TickObserver::Install observe(&writes);
+  OrderedPass pass;
+  OrderedPass::Install ordered(&pass);
+  pass.begin();
+  goal.set(Goal{1});
+  EXPECT_EQ(goal.get(), Goal{1});
+  EXPECT_EQ(writes.writes, 1);
+  // Set before it was read, so the commit needs no other pass.
+  EXPECT_FALSE(registry->sync());
+  EXPECT_EQ(goal.version(), 1);
+}
+
+TEST(Mutable, PlainTypesIgnoreOrderedPass) {
+  auto registry = std::make_shared<MutableRegistry>();
+  Mutable<Sample> sample(registry);
+  Writes writes;
+  TickObserver::Install observe(&writes);
+  OrderedPass pass;
+  OrderedPass::Install ordered(&pass);
+  pass.begin();
+  sample.set(Sample{1});
+  EXPECT_EQ(sample.get(), Sample{});
+  EXPECT_EQ(sample.version(), 0);
+  EXPECT_EQ(writes.writes, 0);
+  EXPECT_TRUE(registry->sync());
+  EXPECT_EQ(sample.get(), Sample{1});
+  EXPECT_EQ(sample.version(), 1);
+  EXPECT_FALSE(registry->sync());
+}
+
+TEST(Mutable, NoHistoryByDefault) {
+  auto registry = std::make_shared<MutableRegistry>();
+  Mutable<int> mutable_int(registry);
+  mutable_int.set(1);
+  registry->sync();
+  EXPECT_TRUE(mutable_int.history().empty());
+}
+
+TEST(Mutable, HistoryKeepsRecentCommitsNewestFirst) {
+  auto registry = std::make_shared<MutableRegistry>();
+  auto mut = std::make_shared<Mutable<Sample>>(registry);
+  Mutator<Sample> mutator(mut);
+  for (int i = 1; i <= 5; ++i) {
+    mutator.set(Sample{i});
+    registry->sync();
+    // Unchanged values are not commits.
+    registry->sync();
+  }
+  History<Sample> history = mutator.history();
+  ASSERT_EQ(history.size(), 3);
+  EXPECT_EQ(history.capacity(), 3);
+  EXPECT_EQ(history.newest().value.value, 5);
+  EXPECT_EQ(history.oldest().value.value, 3);
+  EXPECT_LE(history.oldest().at, history.newest().at);
+
+  std::vector<int> values;
+  for (auto const& committed : history) values.push_back(committed.value.value);
+  EXPECT_EQ(values, (std::vector<int>{5, 4, 3}));
+  EXPECT_EQ(&history[0], &mut->history()[0]);
+}
+
+TEST(Mutable, HistoryIsStampedWithRegistryClock) {
+  auto registry = std::make_shared<MutableRegistry>();
+  auto now = std::chrono::steady_clock::time_point{} + std::chrono::seconds(1);
+  registry->stamp_with([&] {return now;});
+  Mutable<Sample> mut(registry);
+  mut.set(Sample{1});
+  registry->sync();
+  now += std::chrono::seconds(1);
+  mut.set(Sample{2});
+  registry->sync();
+  ASSERT_EQ(mut.history().size(), 2);
+  EXPECT_EQ(mut.history().newest().at, now);
+  EXPECT_EQ(mut.history().oldest().at, now - std::chrono::seconds(1));
+}
+
+TEST(Mutable, RegistersFromOtherThreadsAtNextSync) {
+  auto registry = std::make_shared<MutableRegistry>();
+  std::unique_ptr<Mutable<int>> mut;
+  std::thread([&] {mut = std::make_unique<Mutable<int>>(registry);}).join();
+  EXPECT_EQ(registry->size(), 0);
+  mut->set(1);
+  EXPECT_EQ(true, registry->sync());
+  EXPECT_EQ(registry->size(), 1);
+  std::thread([&] {mut.reset();}).join();
+  EXPECT_EQ(false, registry->sync());
+  EXPECT_EQ(registry->size(), 0);
+}
+
+TEST(Mutable, FreedSlotsAreReusedWithNewGeneration) {
+  auto registry = std::make_shared<MutableRegistry>();
+  auto first = std::make_unique<Mutable<int>>(registry);
+  MutableHandle handle = *first->handle();
+  registry->sync();
+  EXPECT_TRUE(registry->contains(handle));
+  first.reset();
+  registry->sync();
+  EXPECT_FALSE(registry->contains(handle));
+
+  Mutable<int> second(registry);
+  registry->sync();
+  EXPECT_EQ(second.handle()->index, handle.index);
+  EXPECT_NE(second.handle()->generation, handle.generation);
+  EXPECT_FALSE(registry->contains(handle));
+  EXPECT_TRUE(registry->contains(*second.handle()));
+}
+
+TEST(Mutable, RemovalKeepsTheRestCommitting) {
+  auto registry = std::make_shared<MutableRegistry>();
+  std::vector<std::unique_ptr<Mutable<int>>> muts;
+  for (int i = 0; i < 100; ++i) muts.push_back(std::make_unique<Mutable<int>>(registry));
+  registry->sync();
+  for (int i = 0; i < 100; i += 3) muts[i].reset();
+  for (auto& mut : muts) if (mut) mut->set(7);
+  EXPECT_EQ(true, registry->sync());
+  for (auto& mut : muts) {
+    if (mut) {
+      EXPECT_EQ(mut->get(), 7);
+    }
+  }
+  EXPECT_EQ(registry->size(), 66);
+}
+
+TEST(Mutable, ConstructionAndDestructionRaceWithSync) {
+  auto registry = std::make_shared<MutableRegistry>();
+  Mutable<int> kept(registry);
+  std::vector<std::vector<std::unique_ptr<Mutable<int>>>> built(4);
+  std::atomic<int> running = 4;
+  std::vector<std::thread> loaders;
+  for (int t = 0; t < 4; ++t) {
+    loaders.emplace_back([&, t] {
+      for (int i = 0; i < 2000; ++i) {
+	built[t].push_back(std::make_unique<Mutable<int>>(registry));
+	if (i % 3 == 0) built[t].erase(built[t].begin() + i % built[t].size());
+      }
+      --running;
+    });
+  }
+  int value = 0;
+  while (running) {
+    kept.set(++value);
+    EXPECT_EQ(true, registry->sync());
+  }
+  for (auto& loader : loaders) loader.join();
+  // Drop half of them on a thread other than the one that made them.
+  std::thread([&] {for (auto& mine : built) mine.resize(mine.size() / 2);}).join();
+  registry->sync();
+  std::size_t live = 1;
+  for (auto const& mine : built) live += mine.size();
+  EXPECT_EQ(registry->size(), live);
+}
@@ -0,0 +1,35 @@
+#include "random_tree.h"
+
+#include <vector>
+
+namespace tickles {
+
+namespace random_tree {
+
+Result leaf_result(std::uint64_t seed, LeafMix const& leaves) {
+  double total = leaves.running + leaves.succeeded + leaves.failed;
+  double draw = static_cast<double>(mix(seed) >> 11) * 0x1.0p-53 * total;
+  if (draw < leaves.running) return Result::Running;
+  if (draw < leaves.running + leaves.succeeded) return Result::Succeeded;
+  return Result::Failed;
+}
+
+} // namespace random_tree
+
+AnyNode make_dynamic_tree(std::uint64_t seed, std::size_t depth, std::size_t fan_out,
+			  LeafMix const& leaves) {
+  if (depth <= 1) return RandomLeaf{random_tree::leaf_result(seed, leaves)};
+  std::vector<AnyNode> children;
+  children.reserve(fan_out);
+  for (std::size_t i = 0; i < fan_out; ++i) {
+    children.push_back(make_dynamic_tree(random_tree::child_seed(seed, i), depth - 1, fan_out, leaves));
+  }
+  switch (random_tree::kind(seed)) {
+  case Combine::Sequence: return DynamicSequence(std::move(children));
+  case Combine::FallBack: return DynamicFallBack(std::move(children));
+  case Combine::Parallel: return DynamicParallel(std::move(children));
+  }
+  return RandomLeaf{Result::Failed};
+}
+
+} // namespace tickles
@@ -0,0 +1,117 @@
+#ifndef TICKLES_RANDOM_TREE_H
+#define TICKLES_RANDOM_TREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+
+#include "any_node.h"
+#include "behavior_tree.h"
+#include "tree_traits.h"
+
+namespace tickles {
+
+  // Generated trees for tests and benchmarks at realistic sizes.
+  //
+  // RandomTree<Seed, Depth, FanOut> is a tree type with Depth levels and
+  // FanOut children under every composite, each composite picked from
+  // Sequence, FallBack and Parallel by a hash of Seed and its position, or
+  // from their hooked counterparts when ticking is Ticking::Hooked.
+  // make_random_tree() builds one and gives each leaf a result drawn from a
+  // LeafMix; make_dynamic_tree() builds the same tree, with the same leaf
+  // results, out of the dynamic composites at runtime.
+
+  // Relative weights of the results leaves are given.
+  struct LeafMix {
+    double running = 1;
+    double succeeded = 1;
+    double failed = 1;
+  };
+
+  // Returns whatever it was built with. Kept opaque to the optimizer by
+  // holding the result as data rather than in its type.
+  struct RandomLeaf {
+    Result result;
+    Result operator()() const {return result;}
+  };
+
+  namespace random_tree {
+
+    constexpr std::uint64_t mix(std::uint64_t x) {
+      x += 0x9e3779b97f4a7c15;
+      x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+      x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+      return x ^ (x >> 31);
+    }
+
+    constexpr std::uint64_t child_seed(std::uint64_t seed, std::size_t i) {
+      return mix(seed * 31 + i + 1);
+    }
+
+    constexpr Combine kind(std::uint64_t seed) {
+      return static_cast<Combine>(mix(seed) % 3);
+    }
+
+    Result leaf_result(std::uint64_t seed, LeafMix const& leaves);
+
+    template <Combine kind, Ticking ticking, typename... Children>
+    struct composite;
+    template <typename... Children>
+    struct composite<Combine::Sequence, Ticking::Static, Children...> {using type = Sequence<Children...>;};
+    template <typename... Children>
+    struct composite<Combine::FallBack, Ticking::Static, Children...> {using type = FallBack<Children...>;};
+    template <typename... Children>
+    struct composite<Combine::Parallel, Ticking::Static, Children...> {using type = Parallel<Children...>;};
+    template <typename... Children>
+    struct composite<Combine::Sequence, Ticking::Hooked, Children...> {using type = HookedSequence<Children...>;};
+    template <typename... Children>
+    struct composite<Combine::FallBack, Ticking::Hooked, Children...> {using type = HookedFallBack<Children...>;};
+    template <typename... Children>
+    struct composite<Combine::Parallel, Ticking::Hooked, Children...> {using type = HookedParallel<Children...>;};
+
+    template <std::uint64_t Seed, std::size_t Depth, std::size_t FanOut, Ticking ticking>
+    struct node;
+
+    template <std::uint64_t Seed, std::size_t Depth, std::size_t FanOut, Ticking ticking, typename Indices>
+    struct composite_node;
+    template <std::uint64_t Seed, std::size_t Depth, std::size_t FanOut, Ticking ticking, std::size_t... i>
+    struct composite_node<Seed, Depth, FanOut, ticking, std::index_sequence<i...>> {
+      using type = typename composite<kind(Seed), ticking,
+				      typename node<child_seed(Seed, i), Depth - 1, FanOut, ticking>::type...>::type;
+    };
+
+    template <std::uint64_t Seed, std::size_t Depth, std::size_t FanOut, Ticking ticking>
+    struct node : composite_node<Seed, Depth, FanOut, ticking, std::make_index_sequence<FanOut>> {};
+
+    template <std::uint64_t Seed, std::size_t FanOut, Ticking ticking>
+    struct node<Seed, 1, FanOut, ticking> {using type = RandomLeaf;};
+
+    template <typename T>
+    T make(std::uint64_t seed, LeafMix const& leaves) {
+      if constexpr (!CompositeNode<T>) {
+	return T{leaf_result(seed, leaves)};
+      } else {
+	return [&]<std::size_t... i>(std::index_sequence<i...>) {
+	  return T(make<std::tuple_element_t<i, typename T::child_types>>(child_seed(seed, i), leaves)...);
+	}(std::make_index_sequence<child_count_v<T>>{});
+      }
+    }
+
+  } // namespace random_tree
+
+  template <std::uint64_t Seed, std::size_t Depth, std::size_t FanOut, Ticking ticking = Ticking::Static>
+    requires (Depth >= 1 && FanOut >= 1)
+  using RandomTree = typename random_tree::node<Seed, Depth, FanOut, ticking>::type;
+
+  template <std::uint64_t Seed, std::size_t Depth, std::size_t FanOut, Ticking ticking = Ticking::Static>
+  RandomTree<Seed, Depth, FanOut, ticking> make_random_tree(LeafMix const& leaves = {}) {
+    return random_tree::make<RandomTree<Seed, Depth, FanOut, ticking>>(Seed, leaves);
+  }
+
+  AnyNode make_dynamic_tree(std::uint64_t seed, std::size_t depth, std::size_t fan_out,
+			    LeafMix const& leaves = {});
+
+} // namespace tickles
+
+#endif
@@ -0,0 +1,64 @@
+#include <cstdint>
+
+#include "gtest/gtest.h"
+#include "any_node.h"
+#include "behavior_tree.h"
+#include "random_tree.h"
+#include "tree_traits.h"
+
+using tickles::AnyNode;
+using tickles::LeafMix;
+using tickles::RandomTree;
+using tickles::Result;
+using tickles::Ticking;
+using tickles::make_dynamic_tree;
+using tickles::make_random_tree;
+
+static_assert(tickles::leaf_count_v<RandomTree<1, 1, 4>> == 1);
+static_assert(tickles::leaf_count_v<RandomTree<1, 3, 4>> == 16);
+static_assert(tickles::node_count_v<RandomTree<1, 3, 4>> == 21);
+static_assert(tickles::tree_depth_v<RandomTree<7, 4, 2>> == 4);
+static_assert(tickles::max_fan_out_v<RandomTree<7, 4, 2>> == 2);
+
+namespace {
+
+  template <std::uint64_t Seed>
+  void expect_same_results(LeafMix leaves) {
+    auto tree = make_random_tree<Seed, 4, 3>(leaves);
+    auto hooked = make_random_tree<Seed, 4, 3, Ticking::Hooked>(leaves);
+    AnyNode dynamic = make_dynamic_tree(Seed, 4, 3, leaves);
+    EXPECT_EQ(tree(), dynamic()) << "seed " << Seed;
+    EXPECT_EQ(tree(), hooked()) << "seed " << Seed;
+  }
+
+  template <std::uint64_t... Seeds>
+  void expect_same_results_for(LeafMix leaves) {
+    (expect_same_results<Seeds>(leaves), ...);
+  }
+
+}
+
+TEST(RandomTree, DynamicAndHookedTreesMatchStaticTree) {
+  expect_same_results_for<1, 2, 3, 4, 5, 6, 7, 8, 9, 10>({});
+  expect_same_results_for<1, 2, 3, 4, 5, 6, 7, 8, 9, 10>({.running = 0, .succeeded = 9, .failed = 1});
+  expect_same_results_for<1, 2, 3, 4, 5, 6, 7, 8, 9, 10>({.running = 1, .succeeded = 1, .failed = 8});
+}
+
+TEST(RandomTree, LeafMixDecidesLeafResults) {
+  EXPECT_EQ((make_random_tree<3, 1, 1>({.running = 0, .succeeded = 0, .failed = 1})()), Result::Failed);
+  EXPECT_EQ((make_random_tree<3, 1, 1>({.running = 0, .succeeded = 1, .failed = 0})()), Result::Succeeded);
+  EXPECT_EQ(make_dynamic_tree(3, 1, 1, {.running = 1, .succeeded = 0, .failed = 0})(), Result::Running);
+}
+
+TEST(RandomTree, UniformLeavesDecideTheTree) {
+  // With every leaf Succeeded each composite succeeds, whatever its kind.
+  LeafMix succeed{.running = 0, .succeeded = 1, .failed = 0};
+  EXPECT_EQ((make_random_tree<11, 5, 3>(succeed)()), Result::Succeeded);
+  EXPECT_EQ(make_dynamic_tree(11, 5, 3, succeed)(), Result::Succeeded);
+}
+
+TEST(RandomTree, SeedsGiveDifferentShapes) {
+  static_assert(!std::is_same_v<RandomTree<1, 3, 3>, RandomTree<2, 3, 3>> ||
+		!std::is_same_v<RandomTree<2, 3, 3>, RandomTree<3, 3, 3>>);
+  SUCCEED();
+}
@@ -0,0 +1,214 @@
+#ifndef TICKLES_REORDERING_PARALLEL_H
+#define TICKLES_REORDERING_PARALLEL_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <utility>
+
+#include "behavior_tree.h"
+#include "checkpoint.h"
+
+namespace tickles {
+
+  // A node whose Result depends only on what it reads, and which writes
+  // nothing, so that ticking it earlier, later or not at all is unobservable.
+  // Leaves opt in with
+  //
+  //   static constexpr bool pure = true;
+  template <typename T>
+  concept PureNode = BehaviorTreeNode<T> && requires {
+    requires T::pure;
+  };
+
+  // A Parallel of pure children that learns which order to tick them in.
+  //
+  // Parallel stops at the first Failed child, so for children that cannot
+  // observe each other the order only changes how much work a tick does.
+  // Over each window of Window ticks this counts how often every child failed
+  // and, on every CostSampleEvery-th tick, how long it took (or uses its
+  // static tick_cost). At the end of the window the children are sorted by
+  // expected cost per failure found, cost / P(failed), so that cheap children
+  // that are likely to fail run first.
+  template<std::size_t Window, std::size_t CostSampleEvery, PureNode... Children>
+  class BasicReorderingParallel {
+  public:
+    using child_types = std::tuple<Children...>;
+    static constexpr std::size_t size = sizeof...(Children);
+    static constexpr Ticking ticking = ticking_over<Ticking::Static, Children...>;
+
+    BasicReorderingParallel(Children&&... children): children(std::forward<Children>(children)...){
+      std::iota(_order.begin(), _order.end(), 0);
+    }
+    BasicReorderingParallel(BasicReorderingParallel const&) = default;
+    BasicReorderingParallel(BasicReorderingParallel &&) = default;
+
+    Result operator()() const {
+      bool timed = _ticks_in_window % CostSampleEvery == 0;
+      Result result = timed ? in_order<true>() : in_order<false>();
+      if constexpr (ticking == Ticking::Hooked) {
+	if (tick_suspended()) return result;
+	cursor = {};
+      }
+      if (++_ticks_in_window == Window) reorder();
+      return result;
+    }
+
+    // The order children are currently ticked in, by template position.
+    std::array<std::uint32_t, size> const& order() const {return _order;}
+
+    template <typename F>
+    void for_each_child(F&& f) const {
+      std::apply([&](auto const&... child) {(f(child), ...);}, children);
+    }
+
+    // Keeps what has been learned across restarts: the order and the
+    // estimates behind it, but not the window in progress.
+    void save_memory(CheckpointWriter& writer) const {
+      writer.write(_order.data(), sizeof(_order));
+      for (Stats const& s : _stats) {
+	writer.put(s.p_failed);
+	writer.put(s.mean_cost_ns);
+      }
+    }
+
+    // An order that is not a permutation is read past but not applied, so
+    // that the nodes after this one still find their memory.
+    void restore_memory(CheckpointReader& reader) const {
+      std::array<std::uint32_t, size> order{};
+      std::array<Stats, size> stats = _stats;
+      reader.read(order.data(), sizeof(order));
+      for (Stats& s : stats) {
+	reader.get(s.p_failed);
+	reader.get(s.mean_cost_ns);
+      }
+      if (reader.failed()) return;
+      std::array<std::uint32_t, size> sorted = order;
+      std::ranges::sort(sorted);
+      for (std::uint32_t i = 0; i < size; ++i) if (sorted[i] != i) return;
+      _order = order;
+      _stats = stats;
+    }
+
+  private:
+    struct Stats {
+      std::uint32_t ticked = 0;
+      std::uint32_t failed = 0;
+      std::uint32_t timed = 0;
+      double cost_ns = 0;
+      // Estimates carried between windows.
+      double p_failed = 0;
+      double mean_cost_ns = 1;
+    };
+
+    template<bool timed>
+    Result in_order() const {
+      Result so_far = Result::Succeeded;
+      std::uint32_t first = 0;
+      if constexpr (ticking == Ticking::Hooked) {
+	so_far = cursor.partial;
+	first = cursor.next;
+      }
+      for (std::uint32_t k = first; k < size; ++k) {
+	std::uint32_t i = _order[k];
+	Result ith_result = timed ? tick_timed(i) : tick_ith(i);
+	if constexpr (ticking == Ticking::Hooked) {
+	  if (tick_suspended()) {
+	    cursor = {k, so_far};
+	    return Result::Running;
+	  }
+	}
+	_stats[i].failed += ith_result == Result::Failed;
+	if (ith_result == Result::Failed) return Result::Failed;
+	so_far = so_far == Result::Succeeded && ith_result == Result::Succeeded ?
+	  Result::Succeeded : Result::Running;
+	if constexpr (ticking == Ticking::Hooked) {
+	  if (k + 1 == size) break;
+	  switch (at_boundary()) {
+	  case Boundary::Abort: return Result::Running;
+	  case Boundary::Suspend:
+	    cursor = {k + 1, so_far};
+	    return Result::Running;
+	  case Boundary::Continue: break;
+	  }
+	}
+      }
+      return so_far;
+    }
+
+    Result tick_ith(std::uint32_t i) const {
+      ++_stats[i].ticked;
+      return kTickers[i](*this);
+    }
+
+    Result tick_timed(std::uint32_t i) const {
+      auto start = std::chrono::steady_clock::now();
+      Result result = tick_ith(i);
+      _stats[i].cost_ns += std::chrono::duration<double, std::nano>(
+          std::chrono::steady_clock::now() - start).count();
+      ++_stats[i].timed;
+      return result;
+    }
+
+    template<std::size_t i>
+    static Result tick_at(BasicReorderingParallel const& self) {
+      return tick_child<ticking>(std::get<i>(self.children));
+    }
+
+    template<std::size_t i>
+    static constexpr double static_cost() {
+      using Child = std::tuple_element_t<i, child_types>;
+      if constexpr (requires {{Child::tick_cost} -> std::convertible_to<double>;}) return Child::tick_cost;
+      else return -1;
+    }
+
+    void reorder() const {
+      for (std::size_t i = 0; i < size; ++i) {
+	Stats& s = _stats[i];
+	if (s.ticked) s.p_failed = static_cast<double>(s.failed) / s.ticked;
+	if (kStaticCosts[i] >= 0) s.mean_cost_ns = kStaticCosts[i];
+	else if (s.timed) s.mean_cost_ns = s.cost_ns / s.timed;
+	s.ticked = s.failed = s.timed = 0;
+	s.cost_ns = 0;
+      }
+      auto rank = [this](std::uint32_t i) {
+	Stats const& s = _stats[i];
+	return s.p_failed > 0 ? s.mean_cost_ns / s.p_failed : std::numeric_limits<double>::infinity();
+      };
+      std::ranges::stable_sort(_order, [&](std::uint32_t a, std::uint32_t b) {
+	double ra = rank(a), rb = rank(b);
+	if (ra != rb) return ra < rb;
+	return _stats[a].mean_cost_ns < _stats[b].mean_cost_ns;
+      });
+      _ticks_in_window = 0;
+    }
+
+    static constexpr auto kTickers = []<std::size_t... i>(std::index_sequence<i...>) {
+      return std::array<Result (*)(BasicReorderingParallel const&), size>{&tick_at<i>...};
+    }(std::make_index_sequence<size>{});
+
+    static constexpr auto kStaticCosts = []<std::size_t... i>(std::index_sequence<i...>) {
+      return std::array<double, size>{static_cost<i>()...};
+    }(std::make_index_sequence<size>{});
+
+    std::tuple<Children...> children;
+    [[no_unique_address]] mutable cursor_for<ticking> cursor;
+    mutable std::array<std::uint32_t, size> _order;
+    mutable std::array<Stats, size> _stats{};
+    mutable std::size_t _ticks_in_window = 0;
+  };
+
+  template<PureNode... Children>
+  class ReorderingParallel : public BasicReorderingParallel<256, 16, Children...> {
+  public:
+    using BasicReorderingParallel<256, 16, Children...>::BasicReorderingParallel;
+  };
+
+} // namespace tickles
+
+#endif
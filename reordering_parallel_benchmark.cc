@@ -0,0 +1,73 @@
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "behavior_tree.h"
+#include "reordering_parallel.h"
+
+using tickles::Parallel;
+using tickles::ReorderingParallel;
+using tickles::Result;
+
+namespace {
+
+  std::uint32_t mix(std::uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    return x ^ (x >> 16);
+  }
+
+  // A pure condition that burns `work` iterations and fails for
+  // fail_percent of the samples it is shown.
+  template <int salt, int work, int fail_percent>
+  struct Condition {
+    static constexpr bool pure = true;
+    std::uint32_t const* sample;
+
+    Result operator()() const {
+      std::uint32_t h = *sample + salt;
+      for (int i = 0; i < work; ++i) h = mix(h);
+      benchmark::DoNotOptimize(h);
+      return mix(*sample * 31 + salt) % 100 < fail_percent ? Result::Failed : Result::Succeeded;
+    }
+  };
+
+  // Skewed so that the declared order is the worst one: the expensive,
+  // almost always passing checks come first.
+  using A = Condition<1, 200, 1>;
+  using B = Condition<2, 100, 5>;
+  using C = Condition<3, 20, 20>;
+  using D = Condition<4, 2, 60>;
+
+  template <template <typename...> class Composite, typename... Conditions>
+  void run(benchmark::State& state) {
+    std::uint32_t sample = 0;
+    Composite<Conditions...> tree(Conditions{&sample}...);
+    std::uint64_t failed = 0;
+    for (auto _ : state) {
+      ++sample;
+      failed += tree() == Result::Failed;
+    }
+    state.counters["failed"] = benchmark::Counter(static_cast<double>(failed), benchmark::Counter::kAvgIterations);
+  }
+
+}
+
+static void BM_Parallel(benchmark::State& state) {
+  run<Parallel, A, B, C, D>(state);
+}
+BENCHMARK(BM_Parallel);
+
+static void BM_ReorderingParallel(benchmark::State& state) {
+  run<ReorderingParallel, A, B, C, D>(state);
+}
+BENCHMARK(BM_ReorderingParallel);
+
+// Already in the best order: what does the bookkeeping cost?
+static void BM_ParallelBestOrder(benchmark::State& state) {
+  run<Parallel, D, C, B, A>(state);
+}
+BENCHMARK(BM_ParallelBestOrder);
+
+BENCHMARK_MAIN();
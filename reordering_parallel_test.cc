@@ -0,0 +1,78 @@
+#include <array>
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "behavior_tree.h"
+#include "reordering_parallel.h"
+#include "boost/di.hpp"
+
+using tickles::BasicReorderingParallel;
+using tickles::Parallel;
+using tickles::PureNode;
+using tickles::ReorderingParallel;
+using tickles::Result;
+
+namespace {
+
+  // Results follow a fixed pattern over ticks so that tests are repeatable.
+  template <int id, int cost, int fail_every>
+  struct Check {
+    static constexpr bool pure = true;
+    static constexpr double tick_cost = cost;
+    std::shared_ptr<std::array<int, 4>> calls;
+    std::shared_ptr<int> tick;
+
+    Result operator()() const {
+      ++(*calls)[id];
+      return *tick % fail_every == 0 ? Result::Failed : Result::Succeeded;
+    }
+  };
+
+  struct Impure {
+    Result operator()() const {return Result::Succeeded;}
+  };
+
+  // Expensive and rarely failing first, cheap and often failing last.
+  using Rare = Check<0, 100, 50>;
+  using Sometimes = Check<1, 10, 5>;
+  using Often = Check<2, 1, 2>;
+
+  template <typename Tree>
+  Tree make(std::shared_ptr<std::array<int, 4>> calls, std::shared_ptr<int> tick) {
+    return Tree(Rare{calls, tick}, Sometimes{calls, tick}, Often{calls, tick});
+  }
+
+}
+
+static_assert(PureNode<Rare>);
+static_assert(!PureNode<Impure>);
+
+TEST(ReorderingParallel, AgreesWithParallel) {
+  auto calls = std::make_shared<std::array<int, 4>>();
+  auto tick = std::make_shared<int>(0);
+  auto reordering = make<BasicReorderingParallel<8, 1, Rare, Sometimes, Often>>(calls, tick);
+  auto parallel = make<Parallel<Rare, Sometimes, Often>>(calls, tick);
+  for (*tick = 0; *tick < 1000; ++*tick) ASSERT_EQ(reordering(), parallel());
+}
+
+TEST(ReorderingParallel, LearnsToTickLikelyFailuresFirst) {
+  auto calls = std::make_shared<std::array<int, 4>>();
+  auto tick = std::make_shared<int>(1);
+  auto tree = make<BasicReorderingParallel<100, 1, Rare, Sometimes, Often>>(calls, tick);
+  EXPECT_EQ(tree.order(), (std::array<std::uint32_t, 3>{0, 1, 2}));
+  for (; *tick <= 100; ++*tick) tree();
+  EXPECT_EQ(tree.order(), (std::array<std::uint32_t, 3>{2, 1, 0}));
+
+  // Once reordered, Rare runs only when both cheap checks succeed: on odd
+  // ticks that are not multiples of five, instead of on every tick.
+  *calls = {};
+  for (; *tick <= 200; ++*tick) tree();
+  EXPECT_EQ((*calls)[2], 100);
+  EXPECT_EQ((*calls)[1], 50);
+  EXPECT_EQ((*calls)[0], 40);
+}
+
+TEST(ReorderingParallel, BuildsThroughInjector) {
+  auto tree = boost::di::make_injector().create<ReorderingParallel<Rare, Often>>();
+  EXPECT_EQ(tree.order().size(), 2);
+}
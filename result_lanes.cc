@@ -0,0 +1,240 @@
+#include "result_lanes.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TICKLES_LANES_X86 1
+#endif
+
+namespace tickles {
+
+ResultLanes::ResultLanes(std::size_t lanes, Result fill_with)
+  : _lanes(lanes),
+    _words((lanes + kLanesPerBlock - 1) / kLanesPerBlock * kWordsPerBlock),
+    _bits(2 * _words) {
+  fill(fill_with);
+}
+
+void ResultLanes::fill(Result result) {
+  std::fill_n(succeeded(), _words, result == Result::Succeeded ? ~std::uint64_t{0} : 0);
+  std::fill_n(failed(), _words, result == Result::Failed ? ~std::uint64_t{0} : 0);
+  clear_padding();
+}
+
+std::size_t ResultLanes::count(Result result) const {
+  std::size_t n = 0;
+  for (std::size_t w = 0; w < _words; ++w) {
+    switch (result) {
+    case Result::Succeeded: n += std::popcount(succeeded()[w]); break;
+    case Result::Failed: n += std::popcount(failed()[w]); break;
+    case Result::Running: n += std::popcount(~(succeeded()[w] | failed()[w])); break;
+    }
+  }
+  // Padding lanes are Running.
+  return result == Result::Running ? n - (_words * kLanesPerWord - _lanes) : n;
+}
+
+void ResultLanes::clear_padding() {
+  std::size_t full = _lanes / kLanesPerWord;
+  if (full == _words) return;
+  std::uint64_t keep = (std::uint64_t{1} << (_lanes % kLanesPerWord)) - 1;
+  succeeded()[full] &= keep;
+  failed()[full] &= keep;
+  std::fill(succeeded() + full + 1, succeeded() + _words, 0);
+  std::fill(failed() + full + 1, failed() + _words, 0);
+}
+
+namespace {
+
+  // Sequence and FallBack are the same rule with the planes swapped. For a
+  // Sequence "go on" is Succeeded and "stop" is Failed: a lane stops with
+  // the first child that stops it, and ends up Succeeded if every child
+  // let it go on.
+  //
+  //   for each child: stop |= go_on_so_far & child.stop
+  //                   go_on_so_far &= child.go_on
+  //
+  // Parallel fails if any child failed and succeeds if all succeeded.
+  struct Planes {
+    std::uint64_t const* const* go_on;
+    std::uint64_t const* const* stop;
+    std::size_t children;
+    std::uint64_t* out_go_on;
+    std::uint64_t* out_stop;
+    std::size_t words;
+  };
+
+  void chain_reference(Combine kind, std::span<ResultLanes const* const> children, ResultLanes& out) {
+    Result go_on = kind == Combine::Sequence ? Result::Succeeded : Result::Failed;
+    for (std::size_t lane = 0; lane < out.size(); ++lane) {
+      Result result = go_on;
+      for (ResultLanes const* child : children) {
+	result = child->get(lane);
+	if (result != go_on) break;
+      }
+      out.set(lane, result);
+    }
+  }
+
+  void parallel_reference(std::span<ResultLanes const* const> children, ResultLanes& out) {
+    for (std::size_t lane = 0; lane < out.size(); ++lane) {
+      Result so_far = Result::Succeeded;
+      for (ResultLanes const* child : children) {
+	Result result = child->get(lane);
+	if (result == Result::Failed) {
+	  so_far = Result::Failed;
+	  break;
+	}
+	if (result == Result::Running) so_far = Result::Running;
+      }
+      out.set(lane, so_far);
+    }
+  }
+
+  void chain_portable(Planes const& p) {
+    for (std::size_t w = 0; w < p.words; ++w) {
+      std::uint64_t go_on = ~std::uint64_t{0}, stop = 0;
+      for (std::size_t c = 0; c < p.children; ++c) {
+	stop |= go_on & p.stop[c][w];
+	go_on &= p.go_on[c][w];
+      }
+      p.out_go_on[w] = go_on;
+      p.out_stop[w] = stop;
+    }
+  }
+
+  // For Parallel go_on is Succeeded and stop is Failed.
+  void parallel_portable(Planes const& p) {
+    for (std::size_t w = 0; w < p.words; ++w) {
+      std::uint64_t all = ~std::uint64_t{0}, any = 0;
+      for (std::size_t c = 0; c < p.children; ++c) {
+	all &= p.go_on[c][w];
+	any |= p.stop[c][w];
+      }
+      p.out_go_on[w] = all;
+      p.out_stop[w] = any;
+    }
+  }
+
+#ifdef TICKLES_LANES_X86
+
+  void chain_sse2(Planes const& p) {
+    for (std::size_t w = 0; w < p.words; w += 2) {
+      __m128i go_on = _mm_set1_epi32(-1), stop = _mm_setzero_si128();
+      for (std::size_t c = 0; c < p.children; ++c) {
+	stop = _mm_or_si128(stop, _mm_and_si128(go_on, _mm_loadu_si128(reinterpret_cast<__m128i const*>(p.stop[c] + w))));
+	go_on = _mm_and_si128(go_on, _mm_loadu_si128(reinterpret_cast<__m128i const*>(p.go_on[c] + w)));
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(p.out_go_on + w), go_on);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(p.out_stop + w), stop);
+    }
+  }
+
+  void parallel_sse2(Planes const& p) {
+    for (std::size_t w = 0; w < p.words; w += 2) {
+      __m128i all = _mm_set1_epi32(-1), any = _mm_setzero_si128();
+      for (std::size_t c = 0; c < p.children; ++c) {
+	all = _mm_and_si128(all, _mm_loadu_si128(reinterpret_cast<__m128i const*>(p.go_on[c] + w)));
+	any = _mm_or_si128(any, _mm_loadu_si128(reinterpret_cast<__m128i const*>(p.stop[c] + w)));
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(p.out_go_on + w), all);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(p.out_stop + w), any);
+    }
+  }
+
+  __attribute__((target("avx2")))
+  void chain_avx2(Planes const& p) {
+    for (std::size_t w = 0; w < p.words; w += 4) {
+      __m256i go_on = _mm256_set1_epi32(-1), stop = _mm256_setzero_si256();
+      for (std::size_t c = 0; c < p.children; ++c) {
+	stop = _mm256_or_si256(stop, _mm256_and_si256(go_on, _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p.stop[c] + w))));
+	go_on = _mm256_and_si256(go_on, _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p.go_on[c] + w)));
+      }
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(p.out_go_on + w), go_on);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(p.out_stop + w), stop);
+    }
+  }
+
+  __attribute__((target("avx2")))
+  void parallel_avx2(Planes const& p) {
+    for (std::size_t w = 0; w < p.words; w += 4) {
+      __m256i all = _mm256_set1_epi32(-1), any = _mm256_setzero_si256();
+      for (std::size_t c = 0; c < p.children; ++c) {
+	all = _mm256_and_si256(all, _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p.go_on[c] + w)));
+	any = _mm256_or_si256(any, _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p.stop[c] + w)));
+      }
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(p.out_go_on + w), all);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(p.out_stop + w), any);
+    }
+  }
+
+#endif
+
+  // Enough for any real composite without allocating.
+  constexpr std::size_t kMaxInlineChildren = 64;
+
+} // namespace
+
+bool supported(LaneKernel kernel) {
+  switch (kernel) {
+  case LaneKernel::Reference:
+  case LaneKernel::Portable:
+    return true;
+#ifdef TICKLES_LANES_X86
+  case LaneKernel::SSE2: return __builtin_cpu_supports("sse2");
+  case LaneKernel::AVX2: return __builtin_cpu_supports("avx2");
+#else
+  case LaneKernel::SSE2:
+  case LaneKernel::AVX2:
+    return false;
+#endif
+  }
+  return false;
+}
+
+LaneKernel best_lane_kernel() {
+  static LaneKernel const best =
+    supported(LaneKernel::AVX2) ? LaneKernel::AVX2 :
+    supported(LaneKernel::SSE2) ? LaneKernel::SSE2 :
+    LaneKernel::Portable;
+  return best;
+}
+
+void combine(Combine kind, std::span<ResultLanes const* const> children, ResultLanes& out, LaneKernel kernel) {
+  for ([[maybe_unused]] ResultLanes const* child : children) assert(child->size() == out.size());
+  if (kernel == LaneKernel::Reference) {
+    if (kind == Combine::Parallel) parallel_reference(children, out);
+    else chain_reference(kind, children, out);
+    return;
+  }
+
+  std::uint64_t const* inline_planes[2 * kMaxInlineChildren];
+  std::vector<std::uint64_t const*> heap_planes;
+  std::uint64_t const** planes = inline_planes;
+  if (children.size() > kMaxInlineChildren) {
+    heap_planes.resize(2 * children.size());
+    planes = heap_planes.data();
+  }
+  bool swap = kind == Combine::FallBack;
+  for (std::size_t c = 0; c < children.size(); ++c) {
+    planes[c] = swap ? children[c]->failed() : children[c]->succeeded();
+    planes[children.size() + c] = swap ? children[c]->succeeded() : children[c]->failed();
+  }
+  Planes p{planes, planes + children.size(), children.size(),
+	   swap ? out.failed() : out.succeeded(), swap ? out.succeeded() : out.failed(), out.words()};
+
+  bool chain = kind != Combine::Parallel;
+  switch (kernel) {
+#ifdef TICKLES_LANES_X86
+  case LaneKernel::AVX2: chain ? chain_avx2(p) : parallel_avx2(p); break;
+  case LaneKernel::SSE2: chain ? chain_sse2(p) : parallel_sse2(p); break;
+#endif
+  default: chain ? chain_portable(p) : parallel_portable(p); break;
+  }
+  out.clear_padding();
+}
+
+} // namespace tickles
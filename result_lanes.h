@@ -0,0 +1,87 @@
+#ifndef TICKLES_RESULT_LANES_H
+#define TICKLES_RESULT_LANES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "behavior_tree.h"
+
+namespace tickles {
+
+  // The Results of one node for many agents, two bits per agent ("lane").
+  //
+  // The bits are kept as two planes: one with a bit set for every lane that
+  // Succeeded and one for every lane that Failed; a lane with neither is
+  // Running. The combine rules then become a few ANDs and ORs per 64 lanes,
+  // which the SIMD kernels below do 128 or 256 lanes at a time. Planes are
+  // padded to a multiple of kLanesPerBlock, and padding lanes are Running.
+  class ResultLanes {
+  public:
+    static constexpr std::size_t kLanesPerWord = 64;
+    static constexpr std::size_t kWordsPerBlock = 4;
+    static constexpr std::size_t kLanesPerBlock = kLanesPerWord * kWordsPerBlock;
+
+    explicit ResultLanes(std::size_t lanes = 0, Result fill = Result::Running);
+
+    std::size_t size() const {return _lanes;}
+    std::size_t words() const {return _words;}
+
+    Result get(std::size_t lane) const {
+      std::uint64_t bit = std::uint64_t{1} << (lane % kLanesPerWord);
+      std::size_t word = lane / kLanesPerWord;
+      if (succeeded()[word] & bit) return Result::Succeeded;
+      if (failed()[word] & bit) return Result::Failed;
+      return Result::Running;
+    }
+
+    void set(std::size_t lane, Result result) {
+      std::uint64_t bit = std::uint64_t{1} << (lane % kLanesPerWord);
+      std::size_t word = lane / kLanesPerWord;
+      succeeded()[word] = (succeeded()[word] & ~bit) | (result == Result::Succeeded ? bit : 0);
+      failed()[word] = (failed()[word] & ~bit) | (result == Result::Failed ? bit : 0);
+    }
+
+    void fill(Result result);
+    std::size_t count(Result result) const;
+
+    std::uint64_t* succeeded() {return _bits.data();}
+    std::uint64_t const* succeeded() const {return _bits.data();}
+    std::uint64_t* failed() {return _bits.data() + _words;}
+    std::uint64_t const* failed() const {return _bits.data() + _words;}
+
+    // Clears whatever a kernel wrote into the padding.
+    void clear_padding();
+
+    bool operator==(ResultLanes const& other) const = default;
+
+  private:
+    std::size_t _lanes;
+    std::size_t _words;
+    std::vector<std::uint64_t> _bits;
+  };
+
+  enum class LaneKernel {
+    // One lane at a time through the same rules as the composites; what the
+    // others are checked against.
+    Reference,
+    // 64 lanes at a time in general purpose registers.
+    Portable,
+    SSE2,
+    AVX2,
+  };
+
+  bool supported(LaneKernel kernel);
+  // The widest kernel this CPU runs.
+  LaneKernel best_lane_kernel();
+
+  // Combines children lane by lane as a composite of kind would: out lane i
+  // is what the composite returns when child k returns children[k] lane i.
+  // Every child must have as many lanes as out.
+  void combine(Combine kind, std::span<ResultLanes const* const> children, ResultLanes& out,
+	       LaneKernel kernel = best_lane_kernel());
+
+} // namespace tickles
+
+#endif
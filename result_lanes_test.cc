@@ -0,0 +1,104 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "behavior_tree.h"
+#include "result_lanes.h"
+
+using tickles::Combine;
+using tickles::LaneKernel;
+using tickles::Result;
+using tickles::ResultLanes;
+
+namespace {
+
+  ResultLanes random_lanes(std::size_t lanes, std::mt19937& rng) {
+    ResultLanes out(lanes);
+    std::uniform_int_distribution<int> result(0, 2);
+    for (std::size_t i = 0; i < lanes; ++i) out.set(i, static_cast<Result>(result(rng)));
+    return out;
+  }
+
+  std::vector<ResultLanes const*> pointers(std::vector<ResultLanes> const& lanes) {
+    std::vector<ResultLanes const*> out;
+    for (auto const& l : lanes) out.push_back(&l);
+    return out;
+  }
+
+}
+
+TEST(ResultLanes, SetAndGet) {
+  ResultLanes lanes(130);
+  lanes.set(0, Result::Succeeded);
+  lanes.set(64, Result::Failed);
+  lanes.set(129, Result::Succeeded);
+  lanes.set(129, Result::Failed);
+  EXPECT_EQ(lanes.get(0), Result::Succeeded);
+  EXPECT_EQ(lanes.get(1), Result::Running);
+  EXPECT_EQ(lanes.get(64), Result::Failed);
+  EXPECT_EQ(lanes.get(129), Result::Failed);
+  EXPECT_EQ(lanes.count(Result::Failed), 2);
+  EXPECT_EQ(lanes.count(Result::Running), 127);
+  EXPECT_EQ(lanes.words(), 4);
+}
+
+TEST(ResultLanes, MatchesComposites) {
+  ResultLanes running(3, Result::Running), succeeded(3, Result::Succeeded), failed(3, Result::Failed);
+  ResultLanes mixed(3);
+  mixed.set(0, Result::Succeeded);
+  mixed.set(1, Result::Failed);
+  std::vector<ResultLanes const*> children{&mixed, &running};
+  ResultLanes out(3);
+
+  tickles::combine(Combine::Sequence, children, out);
+  EXPECT_EQ(out.get(0), Result::Running);
+  EXPECT_EQ(out.get(1), Result::Failed);
+  EXPECT_EQ(out.get(2), Result::Running);
+
+  tickles::combine(Combine::FallBack, children, out);
+  EXPECT_EQ(out.get(0), Result::Succeeded);
+  EXPECT_EQ(out.get(1), Result::Running);
+  EXPECT_EQ(out.get(2), Result::Running);
+
+  children = {&succeeded, &mixed};
+  tickles::combine(Combine::Parallel, children, out);
+  EXPECT_EQ(out.get(0), Result::Succeeded);
+  EXPECT_EQ(out.get(1), Result::Failed);
+  EXPECT_EQ(out.get(2), Result::Running);
+
+  children = {};
+  tickles::combine(Combine::FallBack, children, out);
+  EXPECT_EQ(out.count(Result::Failed), 3);
+}
+
+TEST(ResultLanes, KernelsAgreeWithReference) {
+  std::mt19937 rng(7);
+  for (LaneKernel kernel : {LaneKernel::Portable, LaneKernel::SSE2, LaneKernel::AVX2}) {
+    if (!tickles::supported(kernel)) continue;
+    for (std::size_t lanes : {0, 1, 63, 64, 65, 255, 256, 257, 1000}) {
+      for (std::size_t n = 0; n <= 5; ++n) {
+	std::vector<ResultLanes> children;
+	for (std::size_t c = 0; c < n; ++c) children.push_back(random_lanes(lanes, rng));
+	for (Combine kind : {Combine::Sequence, Combine::FallBack, Combine::Parallel}) {
+	  ResultLanes expected(lanes), actual(lanes);
+	  tickles::combine(kind, pointers(children), expected, LaneKernel::Reference);
+	  tickles::combine(kind, pointers(children), actual, kernel);
+	  ASSERT_EQ(actual, expected) << "kernel " << static_cast<int>(kernel) << ", "
+				      << lanes << " lanes, " << n << " children";
+	}
+      }
+    }
+  }
+}
+
+TEST(ResultLanes, ManyChildren) {
+  std::mt19937 rng(3);
+  std::vector<ResultLanes> children;
+  for (int c = 0; c < 100; ++c) children.push_back(ResultLanes(300, Result::Succeeded));
+  children[42] = random_lanes(300, rng);
+  ResultLanes expected(300), actual(300);
+  tickles::combine(Combine::Sequence, pointers(children), expected, LaneKernel::Reference);
+  tickles::combine(Combine::Sequence, pointers(children), actual);
+  EXPECT_EQ(actual, expected);
+}
@@ -0,0 +1,160 @@
+#ifndef TICKLES_ROBOT_H
+#define TICKLES_ROBOT_H
+
+#include <algorithm>
+#include <memory>
+
+#include "behavior_tree.h"
+#include "autonomy.h"
+#include "blackboard.h"
+#include "checkpoint.h"
+#include "clock.h"
+#include "history.h"
+#include "mutable.h"
+#include "tree_traits.h"
+
+constexpr int kRechargePosition = 0;
+constexpr int kMaxSpeed = 5;
+constexpr double kMinBattery = 0.2;
+
+struct Position {
+  int position;
+  int velocity;
+};
+
+struct Charge {
+  operator double() const {return charge;}
+  double charge = 1;
+};
+
+struct ChargingState {
+  operator bool() const {return is_charging;}
+  bool is_charging = false;
+};
+
+struct Movement {
+  operator int() const {return velocity;}
+  int velocity;
+};
+
+// Survive a restart, so that a robot that was on its way to recharge
+// still is.
+template <> struct tickles::checkpoint_traits<Position> : tickles::trivial_checkpoint<Position> {};
+template <> struct tickles::checkpoint_traits<Charge> : tickles::trivial_checkpoint<Charge> {};
+template <> struct tickles::checkpoint_traits<ChargingState> : tickles::trivial_checkpoint<ChargingState> {};
+
+// When the robot last changed course, on its own clock.
+template <> struct tickles::mutable_history<Movement> {static constexpr std::size_t depth = 4;};
+
+template <typename T>
+const T& collar(const T& value, const T& min, const T& max) {
+  return std::min(max, std::max(min, value));
+}
+
+struct MoveToRechargeStation {
+  Position const& position;
+  tickles::Mutator<Movement>& mut_movement;
+  
+  tickles::Result operator()() const {
+    if (position.position == kRechargePosition) {
+      mut_movement.set(Movement{.velocity=0});
+      return tickles::Result::Running;
+    }
+    auto distance = -position.position;
+    mut_movement.set(Movement{.velocity=collar(distance, -kMaxSpeed, kMaxSpeed)});
+
+    return tickles::Result::Running;
+  };
+};
+
+struct BatteryOk{
+  tickles::Mutator<ChargingState> charging_state;
+  Charge const& charge;
+  
+  tickles::Result operator()() const {
+    if (charge >= 1.0) {
+      charging_state.set(ChargingState{false});
+      return tickles::Result::Succeeded;
+    }
+    if (charge.charge <= kMinBattery || charging_state.get()) {
+      charging_state.set(ChargingState{true});
+      return tickles::Result::Failed;
+    }
+    return tickles::Result::Succeeded;
+  }
+};
+
+struct GoAboutBusiness {
+  tickles::Mutator<Movement> movement;
+  Position const& position;
+  tickles::Result operator()() const {
+    if (position.position < 500) {
+      movement.set(Movement{.velocity = 10});
+    }
+    return tickles::Result::Running;
+  }
+};
+
+struct EnsureBattery :
+  tickles::FallBack<BatteryOk,
+		    MoveToRechargeStation> {};
+
+struct RobotBehaviorTree : 
+  tickles::Sequence<EnsureBattery,
+		    GoAboutBusiness> {};
+
+static_assert(tickles::within_budget<RobotBehaviorTree, 3>);
+
+struct RobotData {
+  // Inputs
+  std::shared_ptr<tickles::Blackboard<Position, Charge>> inputs;
+  
+  // Outputs
+  std::shared_ptr<const tickles::Mutable<Movement>> movement;
+};
+
+// ClockT is the clock the robot runs on, such as the ManualClock of a
+// simulation.
+template <tickles::TickClock ClockT = tickles::SteadyClock>
+class BasicRobotAutonomy : tickles::Autonomy<RobotData, RobotBehaviorTree, ClockT> {
+  using Autonomy = tickles::Autonomy<RobotData, RobotBehaviorTree, ClockT>;
+  using Autonomy::data;
+  using Autonomy::sync;
+public:
+  BasicRobotAutonomy(){}
+  BasicRobotAutonomy(BasicRobotAutonomy const&) = delete;
+  BasicRobotAutonomy(BasicRobotAutonomy &&) = delete;
+  
+  void position(Position const& position)  {
+    data().inputs->template set<Position>(position);
+    sync();
+  }
+
+  void charge(Charge const& charge) {
+    data().inputs->template set<Charge>(charge);
+    sync();
+  }
+
+  // Both at once, with a single sync.
+  void sense(Position const& position, Charge const& charge) {
+    data().inputs->template set<Position>(position);
+    data().inputs->template set<Charge>(charge);
+    sync();
+  }
+
+  Movement const& movement() const {
+    return data().movement->get();
+  }
+
+  tickles::History<Movement> movement_history() const {
+    return data().movement->history();
+  }
+
+  using Autonomy::checkpoint;
+  using Autonomy::restore;
+  using Autonomy::clock;
+};
+
+using RobotAutonomy = BasicRobotAutonomy<>;
+
+#endif
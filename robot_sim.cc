@@ -0,0 +1,94 @@
+#include "robot_sim.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+
+namespace tickles {
+
+bool ScenarioResult::operator==(ScenarioResult const& other) const {
+  return steps == other.steps && simulated == other.simulated && recharges == other.recharges &&
+    depleted_steps == other.depleted_steps && min_charge == other.min_charge &&
+    last_course_change == other.last_course_change &&
+    max_position == other.max_position && final_position.position == other.final_position.position &&
+    final_position.velocity == other.final_position.velocity && final_charge.charge == other.final_charge.charge;
+}
+
+ScenarioResult simulate(Scenario const& scenario) {
+  RobotModel const& model = scenario.model;
+  std::mt19937_64 rng(scenario.seed);
+  std::uniform_real_distribution<double> noise(1 - model.drain_noise, 1 + model.drain_noise);
+  BasicRobotAutonomy<ManualClock> robot;
+  ManualClock& clock = robot.clock();
+  auto start = clock.now();
+  auto end = start + scenario.duration;
+
+  Position position = scenario.start;
+  Charge charge = scenario.charge;
+  ScenarioResult result;
+  result.min_charge = charge.charge;
+  bool charging = false;
+  while (clock.now() < end) {
+    robot.sense(position, charge);
+    // An empty battery leaves the robot stranded wherever it is.
+    int velocity = charge.charge > 0 ? robot.movement().velocity : 0;
+    position = Position{position.position + velocity, velocity};
+
+    bool now_charging = velocity == 0 && position.position == kRechargePosition;
+    result.recharges += now_charging && !charging;
+    charging = now_charging;
+    if (charging) {
+      charge.charge = std::min(1.0, charge.charge + model.recharge);
+    } else {
+      double drain = (model.idle_drain + model.drain_per_speed * std::abs(velocity)) * noise(rng);
+      charge.charge = std::max(0.0, charge.charge - drain);
+    }
+    result.depleted_steps += charge.charge == 0;
+    result.min_charge = std::min(result.min_charge, charge.charge);
+    result.max_position = std::max(result.max_position, position.position);
+    ++result.steps;
+    clock.advance(model.step);
+  }
+  result.simulated = clock.now() - start;
+  if (!robot.movement_history().empty()) result.last_course_change = robot.movement_history().newest().at - start;
+  result.final_position = position;
+  result.final_charge = charge;
+  return result;
+}
+
+double SimulationReport::steps_per_second() const {
+  return wall.count() ? 1e9 * static_cast<double>(steps) / static_cast<double>(wall.count()) : 0;
+}
+
+double SimulationReport::simulated_hours() const {
+  return std::chrono::duration<double, std::ratio<3600>>(simulated).count();
+}
+
+double SimulationReport::speedup() const {
+  return wall.count() ? static_cast<double>(simulated.count()) / static_cast<double>(wall.count()) : 0;
+}
+
+SimulationReport simulate_all(std::span<Scenario const> scenarios, std::size_t threads) {
+  SimulationReport report;
+  report.results.resize(scenarios.size());
+  std::atomic<std::size_t> next = 0;
+  auto work = [&] {
+    for (std::size_t i = next++; i < scenarios.size(); i = next++) report.results[i] = simulate(scenarios[i]);
+  };
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  threads = std::clamp<std::size_t>(threads, 1, std::max<std::size_t>(scenarios.size(), 1));
+  for (std::size_t t = 1; t < threads; ++t) workers.emplace_back(work);
+  work();
+  for (auto& worker : workers) worker.join();
+  report.wall = std::chrono::steady_clock::now() - start;
+  for (ScenarioResult const& result : report.results) {
+    report.steps += result.steps;
+    report.simulated += result.simulated;
+  }
+  return report;
+}
+
+} // namespace tickles
@@ -0,0 +1,78 @@
+#ifndef TICKLES_ROBOT_SIM_H
+#define TICKLES_ROBOT_SIM_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "clock.h"
+#include "robot.h"
+
+namespace tickles {
+
+  // How the simulated world answers the robot's Movement.
+  struct RobotModel {
+    std::chrono::milliseconds step{100};
+    // Charge lost per step standing still, and per unit of speed moving.
+    double idle_drain = 0.0002;
+    double drain_per_speed = 0.0001;
+    // Random variation of the drain, as a fraction of it.
+    double drain_noise = 0.2;
+    // Charge gained per step while stopped at the recharge station.
+    double recharge = 0.01;
+  };
+
+  struct Scenario {
+    Position start{0, 0};
+    Charge charge{1};
+    std::chrono::seconds duration{std::chrono::hours(1)};
+    std::uint64_t seed = 1;
+    RobotModel model;
+  };
+
+  struct ScenarioResult {
+    std::uint64_t steps = 0;
+    std::chrono::nanoseconds simulated{0};
+    // Times the robot started charging at the recharge station.
+    std::uint64_t recharges = 0;
+    // Steps spent with an empty battery; a correct robot never has any.
+    std::uint64_t depleted_steps = 0;
+    double min_charge = 1;
+    int max_position = 0;
+    // When the robot last changed its Movement, by its own clock.
+    std::chrono::nanoseconds last_course_change{0};
+    Position final_position{0, 0};
+    Charge final_charge{1};
+
+    bool operator==(ScenarioResult const& other) const;
+  };
+
+  // Steps one robot through a scenario on a virtual clock, which its
+  // Autonomy is injected with, as fast as it can: each step the robot senses its Position and Charge and syncs
+  // once, and the model moves it by its Movement and drains or recharges the
+  // battery. The same scenario always gives the same result.
+  ScenarioResult simulate(Scenario const& scenario);
+
+  struct SimulationReport {
+    std::vector<ScenarioResult> results;
+    std::uint64_t steps = 0;
+    std::chrono::nanoseconds simulated{0};
+    std::chrono::nanoseconds wall{0};
+
+    double steps_per_second() const;
+    double simulated_hours() const;
+    // Simulated time per second of wall time, over all threads.
+    double speedup() const;
+  };
+
+  // Runs independent scenarios on threads threads, each taking the next
+  // scenario not yet started, so that long and short scenarios balance.
+  SimulationReport simulate_all(std::span<Scenario const> scenarios,
+				std::size_t threads = std::thread::hardware_concurrency());
+
+} // namespace tickles
+
+#endif
@@ -0,0 +1,39 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "robot_sim.h"
+
+// robot_sim [scenarios] [hours per scenario] [threads]
+//
+// Runs RobotAutonomy through independent scenarios, each from a different
+// seed, starting point and charge, and reports how fast it went.
+int main(int argc, char** argv) {
+  std::size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+  long hours = argc > 2 ? std::strtol(argv[2], nullptr, 10) : 24;
+  std::size_t threads = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : std::thread::hardware_concurrency();
+
+  std::vector<tickles::Scenario> scenarios(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    scenarios[i].seed = i;
+    scenarios[i].start = Position{static_cast<int>(i % 1000), 0};
+    scenarios[i].charge = Charge{0.1 + 0.9 * static_cast<double>(i % 97) / 96};
+    scenarios[i].duration = std::chrono::hours(hours);
+  }
+  tickles::SimulationReport report = tickles::simulate_all(scenarios, threads);
+
+  std::size_t depleted = 0;
+  std::uint64_t recharges = 0;
+  for (tickles::ScenarioResult const& result : report.results) {
+    depleted += result.depleted_steps > 0;
+    recharges += result.recharges;
+  }
+  std::printf("scenarios %zu threads %zu\n", count, threads);
+  std::printf("steps %llu in %.3fs: %.0f steps/s\n", static_cast<unsigned long long>(report.steps),
+	      std::chrono::duration<double>(report.wall).count(), report.steps_per_second());
+  std::printf("simulated %.0f hours, %.0fx real time\n", report.simulated_hours(), report.speedup());
+  std::printf("recharges %llu, scenarios that ran flat %zu\n", static_cast<unsigned long long>(recharges), depleted);
+  return 0;
+}
@@ -0,0 +1,76 @@
+#include <chrono>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "robot_sim.h"
+
+using tickles::Scenario;
+using tickles::ScenarioResult;
+using tickles::SimulationReport;
+using tickles::simulate;
+using tickles::simulate_all;
+
+TEST(RobotSim, StepsTheVirtualClock) {
+  Scenario scenario;
+  scenario.duration = std::chrono::minutes(1);
+  ScenarioResult result = simulate(scenario);
+  EXPECT_EQ(result.steps, 600u);
+  EXPECT_EQ(result.simulated, std::chrono::minutes(1));
+  EXPECT_GT(result.max_position, 0);
+}
+
+TEST(RobotSim, ReturnsToRecharge) {
+  Scenario scenario;
+  scenario.start = Position{100, 0};
+  scenario.charge = Charge{0.15};
+  scenario.duration = std::chrono::seconds(30);
+  ScenarioResult result = simulate(scenario);
+  EXPECT_EQ(result.recharges, 1u);
+  EXPECT_EQ(result.depleted_steps, 0u);
+  EXPECT_GT(result.min_charge, 0.1);
+  // Charged up to full, and then went back to work.
+  EXPECT_GT(result.final_position.position, kRechargePosition);
+  EXPECT_GT(result.final_charge.charge, 0.5);
+}
+
+TEST(RobotSim, RobotRunsOnTheVirtualClock) {
+  Scenario scenario;
+  scenario.start = Position{100, 0};
+  scenario.charge = Charge{0.15};
+  scenario.duration = std::chrono::seconds(30);
+  scenario.model.drain_noise = 0;
+  ScenarioResult result = simulate(scenario);
+  // 20 steps back to the station at 0.0007 a step leave 0.136, and 87 more
+  // charge it full: the robot goes back to work on step 107, 10.7s in.
+  EXPECT_EQ(result.last_course_change, std::chrono::milliseconds(10700));
+}
+
+TEST(RobotSim, SameSeedSameResult) {
+  Scenario scenario;
+  scenario.duration = std::chrono::minutes(10);
+  EXPECT_EQ(simulate(scenario), simulate(scenario));
+  Scenario other = scenario;
+  other.seed = 2;
+  EXPECT_FALSE(simulate(scenario) == simulate(other));
+}
+
+TEST(RobotSim, ParallelMatchesSequential) {
+  std::vector<Scenario> scenarios(16);
+  for (std::size_t i = 0; i < scenarios.size(); ++i) {
+    scenarios[i].seed = i;
+    scenarios[i].start = Position{static_cast<int>(i) * 10, 0};
+    scenarios[i].charge = Charge{0.1 + 0.05 * static_cast<double>(i)};
+    scenarios[i].duration = std::chrono::minutes(1 + i);
+  }
+  SimulationReport report = simulate_all(scenarios, 4);
+  ASSERT_EQ(report.results.size(), scenarios.size());
+  std::uint64_t steps = 0;
+  for (std::size_t i = 0; i < scenarios.size(); ++i) {
+    EXPECT_EQ(report.results[i], simulate(scenarios[i])) << i;
+    steps += report.results[i].steps;
+  }
+  EXPECT_EQ(report.steps, steps);
+  EXPECT_DOUBLE_EQ(report.simulated_hours(), 136.0 / 60);
+  EXPECT_GT(report.steps_per_second(), 0);
+}
@@ -0,0 +1,25 @@
+#include "runner.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace tickles {
+
+RealtimeSetup configure_current_thread(RunnerOptions const& options) {
+  RealtimeSetup setup;
+  pthread_t self = pthread_self();
+  if (options.cpu && *options.cpu >= 0 && *options.cpu < CPU_SETSIZE) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(*options.cpu, &cpus);
+    setup.pinned = pthread_setaffinity_np(self, sizeof(cpus), &cpus) == 0;
+  }
+  if (options.fifo_priority) {
+    sched_param param{};
+    param.sched_priority = *options.fifo_priority;
+    setup.fifo = pthread_setschedparam(self, SCHED_FIFO, &param) == 0;
+  }
+  return setup;
+}
+
+} // namespace tickles
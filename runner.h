@@ -0,0 +1,140 @@
+#ifndef TICKLES_RUNNER_H
+#define TICKLES_RUNNER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+
+#include "clock.h"
+#include "histogram.h"
+
+namespace tickles {
+
+  // What to do when a tick ends after the next one was due.
+  enum class MissedTickPolicy {
+    CatchUp,   // keep the original schedule and run the late ticks back to back
+    Skip,      // drop the periods that were missed and stay on the grid
+    Realign,   // start a new grid at the end of the late tick
+  };
+
+  struct RunnerOptions {
+    std::chrono::nanoseconds period{std::chrono::milliseconds(10)};
+    MissedTickPolicy missed_tick_policy = MissedTickPolicy::Skip;
+    // Pin the ticking thread to this CPU.
+    std::optional<int> cpu{};
+    // Ask for SCHED_FIFO at this priority.
+    std::optional<int> fifo_priority{};
+  };
+
+  // What the kernel actually granted; either may be refused without
+  // CAP_SYS_NICE or inside a restricted cpuset, in which case the thread
+  // keeps running with its previous settings.
+  struct RealtimeSetup {
+    bool pinned = false;
+    bool fifo = false;
+  };
+
+  // Applies options.cpu and options.fifo_priority to the calling thread, for
+  // good: the thread keeps them after the runner returns. A cpu outside
+  // [0, CPU_SETSIZE) is refused.
+  RealtimeSetup configure_current_thread(RunnerOptions const& options);
+
+  struct RunnerStats {
+    std::uint64_t ticks = 0;
+    // Ticks that ended after the next one was due.
+    std::uint64_t overruns = 0;
+    // Periods dropped under MissedTickPolicy::Skip.
+    std::uint64_t skipped = 0;
+    // Nanoseconds between the scheduled and the actual start of a tick.
+    Histogram jitter;
+    // Nanoseconds each tick took.
+    Histogram tick_time;
+    // Nanoseconds by which an overrunning tick missed the next deadline.
+    Histogram overrun;
+  };
+
+  // Ticks something with a sync() (an Autonomy) or a plain callable at a fixed
+  // rate on absolute deadlines, so wakeups do not drift with tick time.
+  template <SleepingClock ClockT = SteadyClock>
+  class FixedRateRunner {
+  public:
+    using time_point = typename ClockT::time_point;
+
+    FixedRateRunner(RunnerOptions options, std::shared_ptr<ClockT> clock = std::make_shared<ClockT>())
+      : _options(options), _clock(std::move(clock)) {}
+    FixedRateRunner(FixedRateRunner const&) = delete;
+    FixedRateRunner(FixedRateRunner &&) = delete;
+
+    // Runs on the calling thread until stop() or max_ticks ticks. Returns
+    // at once if stop() was called before, from any thread, until reset().
+    template <typename Ticked>
+    RunnerStats const& run(Ticked& ticked, std::uint64_t max_ticks = std::numeric_limits<std::uint64_t>::max()) {
+      _setup = configure_current_thread(_options);
+      time_point next = _clock->now();
+      for (std::uint64_t i = 0; i < max_ticks && !_stopped.load(std::memory_order_relaxed); ++i) {
+	_clock->sleep_until(next);
+	time_point start = _clock->now();
+	tick(ticked);
+	time_point end = _clock->now();
+	record(start - next, end - start);
+	next = schedule(next + _options.period, end);
+      }
+      return _stats;
+    }
+
+    void stop() {_stopped.store(true, std::memory_order_relaxed);}
+    // Lets a stopped runner run() again.
+    void reset() {_stopped.store(false, std::memory_order_relaxed);}
+
+    RunnerStats const& stats() const {return _stats;}
+    RealtimeSetup const& realtime_setup() const {return _setup;}
+
+  private:
+    template <typename Ticked>
+    static void tick(Ticked& ticked) {
+      if constexpr (requires {ticked.sync();}) ticked.sync();
+      else ticked();
+    }
+
+    static std::uint64_t nanos(typename ClockT::duration d) {
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+      return ns > 0 ? static_cast<std::uint64_t>(ns) : 0;
+    }
+
+    void record(typename ClockT::duration late, typename ClockT::duration took) {
+      ++_stats.ticks;
+      _stats.jitter.record(nanos(late));
+      _stats.tick_time.record(nanos(took));
+    }
+
+    time_point schedule(time_point due, time_point end) {
+      if (end <= due) return due;
+      ++_stats.overruns;
+      _stats.overrun.record(nanos(end - due));
+      switch (_options.missed_tick_policy) {
+      case MissedTickPolicy::CatchUp:
+	return due;
+      case MissedTickPolicy::Skip: {
+	auto missed = (end - due) / _options.period + 1;
+	_stats.skipped += missed;
+	return due + missed * _options.period;
+      }
+      case MissedTickPolicy::Realign:
+	return end;
+      }
+      return due;
+    }
+
+    RunnerOptions _options;
+    std::shared_ptr<ClockT> _clock;
+    RunnerStats _stats;
+    RealtimeSetup _setup;
+    std::atomic<bool> _stopped = false;
+  };
+
+} // namespace tickles
+
+#endif
@@ -0,0 +1,138 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "clock.h"
+#include "histogram.h"
+#include "runner.h"
+
+using tickles::FixedRateRunner;
+using tickles::Histogram;
+using tickles::ManualClock;
+using tickles::MissedTickPolicy;
+using tickles::RealtimeSetup;
+using tickles::RunnerOptions;
+using tickles::SteadyClock;
+
+using namespace std::chrono_literals;
+
+namespace {
+
+  // Takes a scripted amount of virtual time per tick and records when it ran.
+  struct Scripted {
+    std::shared_ptr<ManualClock> clock;
+    std::vector<ManualClock::duration> durations;
+    std::vector<ManualClock::duration> started{};
+    ManualClock::time_point origin = clock->now();
+
+    void sync() {
+      started.push_back(clock->now() - origin);
+      clock->advance(durations[(started.size() - 1) % durations.size()]);
+    }
+  };
+
+  RunnerOptions every_10ms(MissedTickPolicy policy) {
+    return RunnerOptions{.period = 10ms, .missed_tick_policy = policy};
+  }
+
+}
+
+TEST(Runner, TicksOnAbsoluteDeadlines) {
+  auto clock = std::make_shared<ManualClock>();
+  FixedRateRunner<ManualClock> runner(every_10ms(MissedTickPolicy::Skip), clock);
+  Scripted ticked{clock, {3ms, 7ms, 1ms}};
+  auto const& stats = runner.run(ticked, 4);
+  EXPECT_EQ(ticked.started, (std::vector<ManualClock::duration>{0ms, 10ms, 20ms, 30ms}));
+  EXPECT_EQ(stats.ticks, 4);
+  EXPECT_EQ(stats.overruns, 0);
+  EXPECT_EQ(stats.jitter.max(), 0);
+  EXPECT_EQ(stats.tick_time.max(), 7'000'000);
+}
+
+TEST(Runner, SkipDropsMissedPeriods) {
+  auto clock = std::make_shared<ManualClock>();
+  FixedRateRunner<ManualClock> runner(every_10ms(MissedTickPolicy::Skip), clock);
+  Scripted ticked{clock, {25ms, 1ms, 1ms}};
+  auto const& stats = runner.run(ticked, 3);
+  EXPECT_EQ(ticked.started, (std::vector<ManualClock::duration>{0ms, 30ms, 40ms}));
+  EXPECT_EQ(stats.overruns, 1);
+  EXPECT_EQ(stats.skipped, 2);
+  EXPECT_EQ(stats.overrun.max(), 15'000'000);
+}
+
+TEST(Runner, CatchUpKeepsSchedule) {
+  auto clock = std::make_shared<ManualClock>();
+  FixedRateRunner<ManualClock> runner(every_10ms(MissedTickPolicy::CatchUp), clock);
+  Scripted ticked{clock, {25ms, 1ms, 1ms, 1ms}};
+  auto const& stats = runner.run(ticked, 4);
+  EXPECT_EQ(ticked.started, (std::vector<ManualClock::duration>{0ms, 25ms, 26ms, 30ms}));
+  EXPECT_EQ(stats.overruns, 2);
+  EXPECT_EQ(stats.skipped, 0);
+  EXPECT_EQ(stats.jitter.max(), 15'000'000);
+}
+
+TEST(Runner, RealignStartsNewGrid) {
+  auto clock = std::make_shared<ManualClock>();
+  FixedRateRunner<ManualClock> runner(every_10ms(MissedTickPolicy::Realign), clock);
+  Scripted ticked{clock, {25ms, 1ms, 1ms}};
+  runner.run(ticked, 3);
+  EXPECT_EQ(ticked.started, (std::vector<ManualClock::duration>{0ms, 25ms, 35ms}));
+}
+
+TEST(Runner, StopEndsRun) {
+  auto clock = std::make_shared<ManualClock>();
+  FixedRateRunner<ManualClock> runner(every_10ms(MissedTickPolicy::Skip), clock);
+  int ticks = 0;
+  auto ticked = [&] {if (++ticks == 5) runner.stop();};
+  EXPECT_EQ(runner.run(ticked).ticks, 5);
+}
+
+TEST(Runner, StopBeforeRunIsKept) {
+  auto clock = std::make_shared<ManualClock>();
+  FixedRateRunner<ManualClock> runner(every_10ms(MissedTickPolicy::Skip), clock);
+  int ticks = 0;
+  auto ticked = [&] {++ticks;};
+  runner.stop();
+  EXPECT_EQ(runner.run(ticked, 3).ticks, 0);
+  runner.reset();
+  EXPECT_EQ(runner.run(ticked, 3).ticks, 3);
+}
+
+// On a thread of its own, which keeps the pinning and scheduling class.
+TEST(Runner, RealtimeRequestsFallBackGracefully) {
+  RunnerOptions options{.period = 1ms, .cpu = 0, .fifo_priority = 10};
+  FixedRateRunner<SteadyClock> runner(options);
+  int ticks = 0;
+  auto ticked = [&] {++ticks;};
+  std::chrono::steady_clock::duration elapsed{};
+  std::thread([&] {
+    auto start = std::chrono::steady_clock::now();
+    runner.run(ticked, 20);
+    elapsed = std::chrono::steady_clock::now() - start;
+  }).join();
+  EXPECT_EQ(ticks, 20);
+  // Nineteen full periods pass between the first and the last tick.
+  EXPECT_GE(elapsed, 19ms);
+}
+
+TEST(Runner, RefusesCpuOutOfRange) {
+  RealtimeSetup setup;
+  std::thread([&] {
+    setup = tickles::configure_current_thread(RunnerOptions{.cpu = 1 << 20});
+  }).join();
+  EXPECT_FALSE(setup.pinned);
+}
+
+TEST(Histogram, BucketsArePowersOfTwo) {
+  Histogram histogram;
+  for (std::uint64_t v : {0, 1, 2, 3, 4, 1000}) histogram.record(v);
+  EXPECT_EQ(histogram.count(), 6);
+  EXPECT_EQ(histogram.bucket(0), 1);
+  EXPECT_EQ(histogram.bucket(1), 1);
+  EXPECT_EQ(histogram.bucket(2), 2);
+  EXPECT_EQ(histogram.bucket(3), 1);
+  EXPECT_EQ(histogram.bucket(10), 1);
+  EXPECT_EQ(histogram.quantile(0.5), 3);
+  EXPECT_EQ(histogram.quantile(1.0), 1000);
+}
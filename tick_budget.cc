@@ -0,0 +1,12 @@
+#include "tick_budget.h"
+
+#include "type_name.h"
+
+namespace tickles {
+
+std::string Overrun::node_name() const {
+  if (!node) return "<unknown>";
+  return type_name(*node);
+}
+
+} // namespace tickles
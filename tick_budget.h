@@ -0,0 +1,84 @@
+#ifndef TICKLES_TICK_BUDGET_H
+#define TICKLES_TICK_BUDGET_H
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <typeinfo>
+
+#include "clock.h"
+
+namespace tickles {
+
+  struct Overrun {
+    // The first node that finished evaluating after the deadline.
+    std::type_info const* node;
+    std::chrono::steady_clock::duration late_by;
+
+    std::string node_name() const;
+  };
+
+  // Time budget for the tick running on this thread. While one is installed
+  // the hooked composites in behavior_tree.h (see Ticking) look at the clock
+  // after every child and stop ticking further children once the deadline
+  // has passed; a static composite only ever stops as a whole. With Abort
+  // they give up on the rest of the tick; with Suspend they remember where
+  // they stopped and carry on from there the next time they are ticked.
+  class TickBudget {
+  public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    enum Mode {Abort, Suspend};
+
+    template <TickClock ClockT>
+      requires std::same_as<typename ClockT::time_point, time_point>
+    TickBudget(ClockT const& clock, time_point deadline, Mode mode = Abort)
+      : _clock(&clock),
+	_now([](void const* c) {return static_cast<ClockT const*>(c)->now();}),
+	_deadline(deadline),
+	_mode(mode),
+	_previous(_current) {
+      _current = this;
+    }
+    TickBudget(TickBudget const&) = delete;
+    TickBudget(TickBudget &&) = delete;
+    ~TickBudget() {_current = _previous;}
+
+    static TickBudget* current() {return _current;}
+
+    time_point deadline() const {return _deadline;}
+    bool exhausted() const {return _overrun.has_value();}
+    std::optional<Overrun> const& overrun() const {return _overrun;}
+
+    Mode mode() const {return _mode;}
+    // Set once a composite has parked the tick at a child boundary.
+    bool suspended() const {return _suspended;}
+    void suspend() {_suspended = true;}
+
+    // Called once node has returned; latches the first overrun.
+    void check(std::type_info const& node) {
+      if (_overrun) return;
+      auto now = _now(_clock);
+      if (now > _deadline) _overrun = Overrun{&node, now - _deadline};
+    }
+
+  private:
+    void const* _clock;
+    time_point (*_now)(void const*);
+    time_point _deadline;
+    Mode _mode;
+    bool _suspended = false;
+    std::optional<Overrun> _overrun;
+    TickBudget* _previous;
+
+    static inline thread_local TickBudget* _current = nullptr;
+  };
+
+  inline bool tick_suspended() {
+    TickBudget* budget = TickBudget::current();
+    return budget && budget->suspended();
+  }
+
+} // namespace tickles
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef TICKLES_TICK_OBSERVER_H
+#define TICKLES_TICK_OBSERVER_H
+
+#include <cstdint>
+#include <typeinfo>
+#include <vector>
+
+namespace tickles {
+
+  class MutableBase;
+
+  // Hooks through which a sync() reports what it does, for tracing, metrics
+  // and the like, none of which the core depends on.
+  //
+  // An Autonomy given an observer installs it on the tick thread for the
+  // duration of each sync(). While one is installed, tick() reports every
+  // node a hooked composite evaluates (see Ticking), Mutables of types that
+  // take mutable_hooks report the writes (and, in ordered passes, the reads)
+  // made under them, and the MutableRegistry reports its commits. While none
+  // is, each of those costs a thread-local load and a branch, and static
+  // composites and the other Mutables cost nothing; mutable_benchmark
+  // measures both kinds.
+  class TickObserver {
+  public:
+    TickObserver() = default;
+    TickObserver(TickObserver const&) = delete;
+    virtual ~TickObserver() = default;
+
+    // Asked as every sync() starts; one that says no is not installed.
+    virtual bool active() const {return true;}
+
+    // resuming is true for a sync_slice() that picks up a parked pass.
+    virtual void begin_sync(std::type_info const& tree, bool resuming) {}
+    virtual void end_sync(std::type_info const& tree) {}
+    virtual void begin_pass(std::type_info const& tree) {}
+    virtual void end_pass(std::type_info const& tree) {}
+    virtual void begin_node(std::type_info const& node) {}
+    virtual void end_node(std::type_info const& node) {}
+
+    // mut changed its value in a set(), or was read in an ordered pass.
+    virtual void wrote(MutableBase const& mut) {}
+    virtual void read(MutableBase const& mut) {}
+
+    // A MutableRegistry::sync(). again is whether mut's commit alone calls
+    // for another pass, and whether any of them did.
+    virtual void begin_commit() {}
+    virtual void committed(MutableBase const& mut, std::type_info const& value, bool again) {}
+    virtual void end_commit(std::uint64_t committed, bool again) {}
+
+    // Makes observer, which may be null, the one this thread reports to.
+    class Install {
+    public:
+      explicit Install(TickObserver* observer) : _previous(_current) {_current = observer;}
+      Install(Install const&) = delete;
+      ~Install() {_current = _previous;}
+    private:
+      TickObserver* _previous;
+    };
+
+    static TickObserver* current() {return _current;}
+
+  private:
+    static inline thread_local TickObserver* _current = nullptr;
+  };
+
+  // Reports to several observers at once, in the order they were added;
+  // those that are not active() when a sync() starts hear nothing of it.
+  class TickObservers : public TickObserver {
+  public:
+    void add(TickObserver& observer) {_all.push_back(&observer);}
+
+    bool active() const override {
+      for (TickObserver* observer : _all) if (observer->active()) return true;
+      return false;
+    }
+
+    void begin_sync(std::type_info const& tree, bool resuming) override {
+      _live.clear();
+      for (TickObserver* observer : _all) if (observer->active()) _live.push_back(observer);
+      for (TickObserver* observer : _live) observer->begin_sync(tree, resuming);
+    }
+    void end_sync(std::type_info const& tree) override {
+      for (TickObserver* observer : _live) observer->end_sync(tree);
+    }
+    void begin_pass(std::type_info const& tree) override {
+      for (TickObserver* observer : _live) observer->begin_pass(tree);
+    }
+    void end_pass(std::type_info const& tree) override {
+      for (TickObserver* observer : _live) observer->end_pass(tree);
+    }
+    void begin_node(std::type_info const& node) override {
+      for (TickObserver* observer : _live) observer->begin_node(node);
+    }
+    void end_node(std::type_info const& node) override {
+      for (TickObserver* observer : _live) observer->end_node(node);
+    }
+    void wrote(MutableBase const& mut) override {
+      for (TickObserver* observer : _live) observer->wrote(mut);
+    }
+    void read(MutableBase const& mut) override {
+      for (TickObserver* observer : _live) observer->read(mut);
+    }
+    void begin_commit() override {
+      for (TickObserver* observer : _live) observer->begin_commit();
+    }
+    void committed(MutableBase const& mut, std::type_info const& value, bool again) override {
+      for (TickObserver* observer : _live) observer->committed(mut, value, again);
+    }
+    void end_commit(std::uint64_t committed, bool again) override {
+      for (TickObserver* observer : _live) observer->end_commit(committed, again);
+    }
+
+  private:
+    std::vector<TickObserver*> _all;
+    std::vector<TickObserver*> _live;
+  };
+
+} // namespace tickles
+
+#endif
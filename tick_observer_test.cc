@@ -0,0 +1,116 @@
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "autonomy.h"
+#include "behavior_tree.h"
+#include "input.h"
+#include "mutable.h"
+#include "tick_observer.h"
+
+using tickles::Autonomy;
+using tickles::Input;
+using tickles::MutableBase;
+using tickles::Mutator;
+using tickles::HookedSequence;
+using tickles::Result;
+using tickles::Sequence;
+using tickles::TickObserver;
+using tickles::TickObservers;
+
+namespace {
+
+  struct Level {
+    int value = 0;
+    bool operator==(Level const&) const = default;
+  };
+
+}
+
+template <> struct tickles::mutable_hooks<Level> {static constexpr bool enabled = true;};
+
+namespace {
+
+  struct CopyIn {
+    Input<int> const& in;
+    Mutator<Level> out;
+    Result operator()() const {
+      out.set(Level{in.get()});
+      return Result::Succeeded;
+    }
+  };
+
+  struct Data {
+    std::shared_ptr<Input<int>> in;
+  };
+
+  using Tree = HookedSequence<CopyIn, tickles::AlwaysSucceeded>;
+
+  struct Copier : Autonomy<Data, Tree> {
+    using Autonomy::sync;
+  };
+
+  struct Counting : TickObserver {
+    bool on = true;
+    int syncs = 0, passes = 0, nodes = 0, open_nodes = 0, writes = 0, commits = 0, changes = 0;
+    TickObserver* installed = nullptr;
+
+    bool active() const override {return on;}
+    void begin_sync(std::type_info const& tree, bool resuming) override {
+      installed = TickObserver::current();
+      ++syncs;
+    }
+    void end_pass(std::type_info const& tree) override {++passes;}
+    void begin_node(std::type_info const& node) override {++open_nodes;}
+    void end_node(std::type_info const& node) override {
+      --open_nodes;
+      ++nodes;
+    }
+    void wrote(MutableBase const& mut) override {++writes;}
+    void committed(MutableBase const& mut, std::type_info const& value, bool again) override {
+      EXPECT_EQ(value, typeid(Level));
+      ++changes;
+    }
+    void end_commit(std::uint64_t count, bool again) override {++commits;}
+  };
+
+}
+
+TEST(TickObserver, SeesEveryNodePassAndCommit) {
+  Counting counting;
+  Copier copier;
+  copier.observe(&counting);
+  copier.data().in->set(1);
+  copier.sync();
+
+  // One pass that commits Level, then one that commits nothing, each
+  // ticking both children of the root.
+  EXPECT_EQ(counting.syncs, 1);
+  EXPECT_EQ(counting.passes, 2);
+  EXPECT_EQ(counting.nodes, 4);
+  EXPECT_EQ(counting.open_nodes, 0);
+  EXPECT_EQ(counting.writes, 1);
+  EXPECT_EQ(counting.commits, 2);
+  EXPECT_EQ(counting.changes, 1);
+  EXPECT_EQ(counting.installed, &counting);
+  EXPECT_EQ(TickObserver::current(), nullptr);
+}
+
+TEST(TickObserver, InactiveObserversHearNothing) {
+  Counting on, off;
+  off.on = false;
+  TickObservers both;
+  both.add(on);
+  both.add(off);
+  Copier copier;
+  copier.observe(&both);
+  copier.sync();
+  EXPECT_EQ(on.syncs, 1);
+  EXPECT_EQ(on.installed, &both);
+  EXPECT_EQ(on.nodes, 2);
+  EXPECT_EQ(off.syncs, 0);
+  EXPECT_EQ(off.nodes, 0);
+
+  on.on = false;
+  copier.sync();
+  EXPECT_EQ(on.syncs, 1);
+}
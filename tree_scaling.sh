@@ -0,0 +1,41 @@
+#!/bin/bash
+# Compile time, binary size and ticks per second of generated template trees.
+#
+# Builds tree_scaling_benchmark.cc once per depth/fan-out configuration and
+# prints one line per configuration and leaf mix. Run from the repository
+# root; CXX and CXXFLAGS are honoured.
+#
+#   ./tree_scaling.sh "2x4 3x4 4x4 5x4 3x8 4x8 8x2"
+
+set -euo pipefail
+
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--std=c++2a -O2}
+CONFIGS=${1:-"2x4 3x4 4x4 3x8 6x2 8x2"}
+LIBS="random_tree.cc behavior_tree.cc tick_budget.cc type_name.cc clock.cc"
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+mkdir "$OUT/lib"
+for lib in $LIBS; do
+  $CXX $CXXFLAGS -I. -c "$lib" -o "$OUT/lib/${lib%.cc}.o"
+done
+
+printf "%-6s %-7s %-10s %-12s %-12s %s\n" depth fan_out compile_s binary_bytes leaf_mix ticks_per_s
+for config in $CONFIGS; do
+  depth=${config%x*}
+  fan_out=${config#*x}
+  binary="$OUT/tree_scaling_${depth}x${fan_out}"
+  start=$(date +%s.%N)
+  $CXX $CXXFLAGS -I. -DTICKLES_SCALING_DEPTH="$depth" -DTICKLES_SCALING_FAN_OUT="$fan_out" \
+    -c tree_scaling_benchmark.cc -o "$binary.o"
+  end=$(date +%s.%N)
+  $CXX "$binary.o" "$OUT"/lib/*.o -lbenchmark -pthread -o "$binary"
+  compile_s=$(awk -v s="$start" -v e="$end" 'BEGIN {print e - s}')
+  bytes=$(stat -c %s "$binary")
+  # ticks/s sorts last among the counters, so it is the last column.
+  "$binary" --benchmark_format=csv 2>/dev/null | tail -n +2 | while IFS= read -r line; do
+    mix=$(echo "$line" | sed -E 's|.*running:([0-9]+)/succeeded:([0-9]+)/failed:([0-9]+).*|\1/\2/\3|')
+    printf "%-6s %-7s %-10.2f %-12s %-12s %.0f\n" "$depth" "$fan_out" "$compile_s" "$bytes" "$mix" "${line##*,}"
+  done
+done
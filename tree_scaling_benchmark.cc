@@ -0,0 +1,96 @@
+#include <cstddef>
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "any_node.h"
+#include "behavior_tree.h"
+#include "random_tree.h"
+#include "tree_traits.h"
+
+using tickles::AnyNode;
+using tickles::LeafMix;
+using tickles::RandomTree;
+using tickles::Result;
+using tickles::Ticking;
+
+// Ticks per second of generated trees over depth, fan-out and leaf results.
+//
+// The template trees swept here are compiled in. Defining
+// TICKLES_SCALING_DEPTH and TICKLES_SCALING_FAN_OUT compiles just that one
+// configuration instead, which is how tree_scaling.sh measures compile time
+// and binary size per configuration.
+
+namespace {
+
+  constexpr std::uint64_t kSeed = 2024;
+
+  // Leaf results as percentages of Running, Succeeded and Failed.
+  LeafMix leaf_mix(benchmark::State const& state, int first) {
+    return LeafMix{static_cast<double>(state.range(first)),
+		   static_cast<double>(state.range(first + 1)),
+		   static_cast<double>(state.range(first + 2))};
+  }
+
+  template <typename Tree>
+  void run(benchmark::State& state, Tree& tree, std::size_t nodes) {
+    std::uint64_t failed = 0;
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(tree);
+      Result result = tree();
+      benchmark::DoNotOptimize(result);
+      failed += result == Result::Failed;
+    }
+    state.counters["ticks/s"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+    state.counters["nodes"] = static_cast<double>(nodes);
+    state.counters["failed"] = benchmark::Counter(static_cast<double>(failed), benchmark::Counter::kAvgIterations);
+  }
+
+  void leaf_mixes(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"running", "succeeded", "failed"});
+    b->Args({0, 90, 10});
+    b->Args({34, 33, 33});
+    b->Args({0, 10, 90});
+  }
+
+}
+
+template <std::size_t Depth, std::size_t FanOut, Ticking ticking = Ticking::Static>
+static void BM_Static(benchmark::State& state) {
+  using Tree = RandomTree<kSeed, Depth, FanOut, ticking>;
+  Tree tree = tickles::make_random_tree<kSeed, Depth, FanOut, ticking>(leaf_mix(state, 0));
+  run(state, tree, tickles::node_count_v<Tree>);
+  state.counters["bytes"] = static_cast<double>(tickles::tree_size_v<Tree>);
+}
+
+// The same trees out of hooked composites, which pay for tick budgets,
+// time slicing and TickObservers whether or not any is in use.
+template <std::size_t Depth, std::size_t FanOut>
+static void BM_Hooked(benchmark::State& state) {BM_Static<Depth, FanOut, Ticking::Hooked>(state);}
+
+#if defined(TICKLES_SCALING_DEPTH) && defined(TICKLES_SCALING_FAN_OUT)
+BENCHMARK_TEMPLATE(BM_Static, TICKLES_SCALING_DEPTH, TICKLES_SCALING_FAN_OUT)->Apply(leaf_mixes);
+#else
+BENCHMARK_TEMPLATE(BM_Static, 2, 4)->Apply(leaf_mixes);
+BENCHMARK_TEMPLATE(BM_Static, 3, 4)->Apply(leaf_mixes);
+BENCHMARK_TEMPLATE(BM_Static, 4, 4)->Apply(leaf_mixes);
+BENCHMARK_TEMPLATE(BM_Static, 3, 8)->Apply(leaf_mixes);
+BENCHMARK_TEMPLATE(BM_Static, 6, 2)->Apply(leaf_mixes);
+BENCHMARK_TEMPLATE(BM_Hooked, 3, 4)->Apply(leaf_mixes);
+BENCHMARK_TEMPLATE(BM_Hooked, 4, 4)->Apply(leaf_mixes);
+
+// The same trees built at runtime from the dynamic composites.
+static void BM_Dynamic(benchmark::State& state) {
+  std::size_t depth = state.range(0), fan_out = state.range(1);
+  AnyNode tree = tickles::make_dynamic_tree(kSeed, depth, fan_out, leaf_mix(state, 2));
+  std::size_t nodes = 0;
+  for (std::size_t level = 0, width = 1; level < depth; ++level, width *= fan_out) nodes += width;
+  run(state, tree, nodes);
+}
+BENCHMARK(BM_Dynamic)
+  ->ArgNames({"depth", "fan_out", "running", "succeeded", "failed"})
+  ->ArgsProduct({{2, 3, 4, 6}, {2, 4, 8}, {0}, {90}, {10}})
+  ->ArgsProduct({{2, 3, 4, 6}, {2, 4, 8}, {34}, {33}, {33}})
+  ->ArgsProduct({{2, 3, 4, 6}, {2, 4, 8}, {0}, {10}, {90}});
+#endif
+
+BENCHMARK_MAIN();
@@ -0,0 +1,248 @@
+#ifndef TICKLES_TREE_TRAITS_H
+#define TICKLES_TREE_TRAITS_H
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "behavior_tree.h"
+
+namespace tickles {
+
+  // Structural metrics and a worst-case cost model for behavior tree types,
+  // all computed at compile time from the type alone.
+  //
+  // Composites and decorators name their children through a child_types
+  // tuple; anything without one is a leaf. A leaf may declare
+  //
+  //   static constexpr double tick_cost = 40;
+  //
+  // in whatever unit the budget is written in (nanoseconds, say); leaves that
+  // do not are charged kDefaultLeafCost and composites cost nothing on their
+  // own unless they declare a tick_cost too.
+
+  inline constexpr double kDefaultLeafCost = 1;
+
+  template <typename T>
+  concept CompositeNode = requires {typename T::child_types;};
+
+  namespace detail {
+    template <typename T>
+    struct child_tuple {using type = std::tuple<>;};
+    template <CompositeNode T>
+    struct child_tuple<T> {using type = typename T::child_types;};
+
+    // Applies F to every child type of T and folds the results with Op.
+    template <typename T, typename F, typename Op, typename V>
+    constexpr V fold_children(F f, Op op, V init) {
+      using children = typename child_tuple<T>::type;
+      return [&]<std::size_t... i>(std::index_sequence<i...>) {
+	V result = init;
+	((result = op(result, f.template operator()<std::tuple_element_t<i, children>>())), ...);
+	return result;
+      }(std::make_index_sequence<std::tuple_size_v<children>>{});
+    }
+
+    constexpr auto plus = [](auto a, auto b) {return a + b;};
+    constexpr auto max = [](auto a, auto b) {return std::max(a, b);};
+  }
+
+  template <typename T>
+  constexpr std::size_t child_count_v = std::tuple_size_v<typename detail::child_tuple<T>::type>;
+
+  // Levels in the tree; a single leaf has depth 1.
+  template <typename T>
+  constexpr std::size_t tree_depth_v =
+    1 + detail::fold_children<T>([]<typename C>() {return tree_depth_v<C>;}, detail::max, std::size_t{0});
+
+  template <typename T>
+  constexpr std::size_t leaf_count_v = !CompositeNode<T> ? 1 :
+    detail::fold_children<T>([]<typename C>() {return leaf_count_v<C>;}, detail::plus, std::size_t{0});
+
+  template <typename T>
+  constexpr std::size_t node_count_v =
+    1 + detail::fold_children<T>([]<typename C>() {return node_count_v<C>;}, detail::plus, std::size_t{0});
+
+  // Most children any single node in the tree has.
+  template <typename T>
+  constexpr std::size_t max_fan_out_v = std::max(
+    child_count_v<T>,
+    detail::fold_children<T>([]<typename C>() {return max_fan_out_v<C>;}, detail::max, std::size_t{0}));
+
+  namespace detail {
+    // Results a node can return, as a mask.
+    inline constexpr unsigned kRunning = 1, kSucceeded = 2, kFailed = 4, kAnyResult = 7;
+
+    template <Ticking t, typename... C>
+    constexpr Combine combine_kind(BasicSequence<t, C...> const*) {return Combine::Sequence;}
+    template <Ticking t, typename... C>
+    constexpr Combine combine_kind(BasicFallBack<t, C...> const*) {return Combine::FallBack;}
+    template <Ticking t, typename... C>
+    constexpr Combine combine_kind(BasicParallel<t, C...> const*) {return Combine::Parallel;}
+
+    template <typename T>
+    concept StandardComposite = requires {combine_kind(static_cast<T const*>(nullptr));};
+
+    struct Reach {
+      std::size_t visits;
+      unsigned results;
+    };
+
+    // Follows the combine rules past every child that can let them go on.
+    template <std::size_t n>
+    constexpr Reach combine_reach(Combine kind, std::array<Reach, n> const& children) {
+      Reach out{1, 0};
+      bool can_succeed = true, can_run = false;
+      for (Reach const& child : children) {
+	out.visits += child.visits;
+	switch (kind) {
+	case Combine::Sequence:
+	  out.results |= child.results & (kRunning | kFailed);
+	  if (!(child.results & kSucceeded)) return out;
+	  break;
+	case Combine::FallBack:
+	  out.results |= child.results & (kRunning | kSucceeded);
+	  if (!(child.results & kFailed)) return out;
+	  break;
+	case Combine::Parallel:
+	  out.results |= child.results & kFailed;
+	  if (!(child.results & (kRunning | kSucceeded))) return out;
+	  can_run = (can_run && (child.results & (kRunning | kSucceeded))) || (can_succeed && (child.results & kRunning));
+	  can_succeed = can_succeed && (child.results & kSucceeded);
+	  break;
+	}
+      }
+      if (kind == Combine::Sequence) out.results |= kSucceeded;
+      else if (kind == Combine::FallBack) out.results |= kFailed;
+      else out.results |= (can_succeed ? kSucceeded : 0) | (can_run ? kRunning : 0);
+      return out;
+    }
+
+    template <typename T>
+    constexpr Reach reach() {
+      if constexpr (std::same_as<T, AlwaysRunning>) return {1, kRunning};
+      else if constexpr (std::same_as<T, AlwaysSucceeded>) return {1, kSucceeded};
+      else if constexpr (std::same_as<T, AlwaysFailed>) return {1, kFailed};
+      else if constexpr (StandardComposite<T>) {
+	using children = typename T::child_types;
+	return combine_reach(combine_kind(static_cast<T const*>(nullptr)), []<std::size_t... i>(std::index_sequence<i...>) {
+	  return std::array<Reach, sizeof...(i)>{reach<std::tuple_element_t<i, children>>()...};
+	}(std::make_index_sequence<std::tuple_size_v<children>>{}));
+      } else {
+	// Decorators and other composites may tick every child and return
+	// anything.
+	return {1 + fold_children<T>([]<typename C>() {return reach<C>().visits;}, plus, std::size_t{0}), kAnyResult};
+      }
+    }
+  }
+
+  // Most nodes one tick can evaluate. Sequence, FallBack and Parallel stop
+  // at a child that cannot return what lets them go on (an AlwaysFailed in
+  // a Sequence, say), so what comes after it is never reached; any other
+  // node may evaluate all of its children.
+  template <typename T>
+  constexpr std::size_t max_nodes_visited_v = detail::reach<T>().visits;
+
+  // Bytes taken by the tree object itself. Composites hold their children
+  // inline, so this is everything but what leaves point to.
+  template <typename T>
+  constexpr std::size_t tree_size_v = sizeof(T);
+
+  template <typename T>
+  constexpr double node_cost_v = [] {
+    if constexpr (requires {{T::tick_cost} -> std::convertible_to<double>;}) return double{T::tick_cost};
+    else if constexpr (CompositeNode<T>) return 0.0;
+    else return kDefaultLeafCost;
+  }();
+
+  template <typename T>
+  constexpr double worst_case_cost_v =
+    node_cost_v<T> + detail::fold_children<T>([]<typename C>() {return worst_case_cost_v<C>;}, detail::plus, 0.0);
+
+  // For static_assert(within_budget<Tree, 250>) next to a tree's definition.
+  template <typename T, auto budget>
+  concept within_budget = worst_case_cost_v<T> <= budget;
+
+  // Leaves may also declare which Mutables they read and write, by value
+  // type, as there is one Mutable<T> per T in an Autonomy:
+  //
+  //   using reads = std::tuple<Goal>;
+  //   using writes = std::tuple<Echo>;
+  //
+  // Leaves that declare neither are taken to touch no Mutable.
+
+  namespace detail {
+    template <typename T>
+    struct reads_of {using type = std::tuple<>;};
+    template <typename T> requires requires {typename T::reads;}
+    struct reads_of<T> {using type = typename T::reads;};
+
+    template <typename T>
+    struct writes_of {using type = std::tuple<>;};
+    template <typename T> requires requires {typename T::writes;}
+    struct writes_of<T> {using type = typename T::writes;};
+
+    template <typename Children>
+    struct leaves_of_all;
+
+    template <typename T>
+    struct leaves_of {using type = std::tuple<T>;};
+    template <CompositeNode T>
+    struct leaves_of<T> {using type = typename leaves_of_all<typename T::child_types>::type;};
+
+    template <typename... Children>
+    struct leaves_of_all<std::tuple<Children...>> {
+      using type = decltype(std::tuple_cat(std::declval<typename leaves_of<Children>::type>()...));
+    };
+
+    template <typename U, typename Tuple>
+    struct in_tuple;
+    template <typename U, typename... Ts>
+    struct in_tuple<U, std::tuple<Ts...>> : std::bool_constant<(std::same_as<U, Ts> || ...)> {};
+
+    // Everything leaves i and on of Leaves write.
+    template <typename Leaves, std::size_t i, bool = (i < std::tuple_size_v<Leaves>)>
+    struct writes_from {using type = std::tuple<>;};
+    template <typename Leaves, std::size_t i>
+    struct writes_from<Leaves, i, true> {
+      using type = decltype(std::tuple_cat(
+	std::declval<typename writes_of<std::tuple_element_t<i, Leaves>>::type>(),
+	std::declval<typename writes_from<Leaves, i + 1>::type>()));
+    };
+
+    template <typename Reads, typename Writes>
+    struct overlaps;
+    template <typename... Reads, typename Writes>
+    struct overlaps<std::tuple<Reads...>, Writes> : std::bool_constant<(in_tuple<Reads, Writes>::value || ...)> {};
+
+    // Whether leaf i of Leaves reads what it or any leaf after it writes.
+    template <typename Leaves, std::size_t i>
+    constexpr bool reads_later_write =
+      overlaps<typename reads_of<std::tuple_element_t<i, Leaves>>::type,
+	       typename writes_from<Leaves, i>::type>::value;
+  }
+
+  // The leaves of T in the order a tick reaches them.
+  template <typename T>
+  using leaf_types = typename detail::leaves_of<T>::type;
+
+  // True if no leaf reads a Mutable written by itself or by a leaf ticked
+  // after it, going by what the leaves declare. An Autonomy that evaluates
+  // such a tree in order settles in a single pass; it never reorders one
+  // that is not.
+  template <typename T>
+  constexpr bool single_pass_v = []<std::size_t... i>(std::index_sequence<i...>) {
+    return !(detail::reads_later_write<leaf_types<T>, i> || ...);
+  }(std::make_index_sequence<std::tuple_size_v<leaf_types<T>>>{});
+
+  // For static_assert(single_pass<Tree>).
+  template <typename T>
+  concept single_pass = single_pass_v<T>;
+
+} // namespace tickles
+
+#endif
@@ -0,0 +1,114 @@
+#include <tuple>
+#include <type_traits>
+
+#include "gtest/gtest.h"
+#include "behavior_tree.h"
+#include "decorators.h"
+#include "input.h"
+#include "tree_traits.h"
+
+using tickles::AlwaysFailed;
+using tickles::AlwaysRunning;
+using tickles::AlwaysSucceeded;
+using tickles::FallBack;
+using tickles::Input;
+using tickles::Memoize;
+using tickles::Parallel;
+using tickles::Result;
+using tickles::Sequence;
+
+using tickles::leaf_count_v;
+using tickles::max_fan_out_v;
+using tickles::max_nodes_visited_v;
+using tickles::leaf_types;
+using tickles::node_count_v;
+using tickles::tree_depth_v;
+using tickles::single_pass;
+using tickles::tree_size_v;
+using tickles::within_budget;
+using tickles::worst_case_cost_v;
+
+namespace {
+
+  struct Expensive {
+    static constexpr double tick_cost = 50;
+    Result operator()() const {return Result::Succeeded;}
+  };
+
+  struct Guard : FallBack<AlwaysFailed, Expensive> {};
+
+  struct Tree : Sequence<Guard,
+			 Parallel<AlwaysRunning, AlwaysSucceeded, AlwaysFailed, Expensive>,
+			 Memoize<Expensive, Input<int>>> {};
+
+}
+
+namespace {
+
+  struct A {};
+  struct B {};
+
+  struct WriteA {
+    using writes = std::tuple<A>;
+    Result operator()() const {return Result::Succeeded;}
+  };
+
+  struct ReadAWriteB {
+    using reads = std::tuple<A>;
+    using writes = std::tuple<B>;
+    Result operator()() const {return Result::Succeeded;}
+  };
+
+  struct ReadB {
+    using reads = std::tuple<B>;
+    Result operator()() const {return Result::Succeeded;}
+  };
+
+  struct UpdateA {
+    using reads = std::tuple<A>;
+    using writes = std::tuple<A>;
+    Result operator()() const {return Result::Succeeded;}
+  };
+
+}
+
+static_assert(std::is_same_v<leaf_types<Guard>, std::tuple<AlwaysFailed, Expensive>>);
+static_assert(std::tuple_size_v<leaf_types<Tree>> == leaf_count_v<Tree>);
+
+static_assert(single_pass<Tree>);
+static_assert(single_pass<Sequence<WriteA, FallBack<AlwaysFailed, ReadAWriteB>, ReadB>>);
+static_assert(!single_pass<Sequence<ReadB, WriteA, ReadAWriteB>>);
+static_assert(!single_pass<Parallel<ReadAWriteB, WriteA>>);
+static_assert(!single_pass<UpdateA>);
+
+static_assert(tree_depth_v<AlwaysRunning> == 1);
+static_assert(leaf_count_v<AlwaysRunning> == 1);
+static_assert(tree_depth_v<Sequence<>> == 1);
+static_assert(leaf_count_v<Sequence<>> == 0);
+
+static_assert(tree_depth_v<Tree> == 3);
+static_assert(leaf_count_v<Tree> == 7);
+static_assert(node_count_v<Tree> == 11);
+static_assert(max_fan_out_v<Tree> == 4);
+// The Parallel always fails at its AlwaysFailed, which ends the Sequence.
+static_assert(max_nodes_visited_v<Tree> == 8);
+static_assert(max_nodes_visited_v<Guard> == 3);
+static_assert(max_nodes_visited_v<Sequence<AlwaysRunning, Expensive>> == 2);
+static_assert(max_nodes_visited_v<FallBack<AlwaysSucceeded, Expensive>> == 2);
+static_assert(max_nodes_visited_v<Parallel<AlwaysRunning, AlwaysSucceeded, Expensive>> == 4);
+static_assert(max_nodes_visited_v<Sequence<Parallel<AlwaysRunning, AlwaysSucceeded>, Expensive>> == 4);
+static_assert(max_nodes_visited_v<Memoize<Sequence<AlwaysFailed, Expensive>, Input<int>>> == 3);
+static_assert(worst_case_cost_v<Tree> == 51 + 53 + 50);
+static_assert(within_budget<Tree, 154>);
+static_assert(!within_budget<Tree, 153>);
+
+TEST(TreeTraits, SizeIsTheInlineObject) {
+  EXPECT_EQ(tree_size_v<Tree>, sizeof(Tree));
+  EXPECT_GE(tree_size_v<Tree>, tree_size_v<Guard>);
+}
+
+TEST(TreeTraits, DerivedTreesInheritStructure) {
+  EXPECT_EQ(tree_depth_v<Guard>, 2);
+  EXPECT_EQ(leaf_count_v<Guard>, 2);
+  EXPECT_EQ(worst_case_cost_v<Guard>, 51);
+}
@@ -0,0 +1,17 @@
+#include "type_name.h"
+
+#include <cstdlib>
+#include <memory>
+
+#include <cxxabi.h>
+
+namespace tickles {
+
+std::string type_name(std::type_info const& type) {
+  int status = 0;
+  std::unique_ptr<char, decltype(&std::free)> demangled(
+      abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), &std::free);
+  return status == 0 ? std::string(demangled.get()) : std::string(type.name());
+}
+
+} // namespace tickles
@@ -0,0 +1,14 @@
+#ifndef TICKLES_TYPE_NAME_H
+#define TICKLES_TYPE_NAME_H
+
+#include <string>
+#include <typeinfo>
+
+namespace tickles {
+
+  // Demangled name of type, for reports.
+  std::string type_name(std::type_info const& type);
+
+} // namespace tickles
+
+#endif